@@ -0,0 +1,74 @@
+#version 430 core
+
+// ray casts the unit sphere (radius 0.5) or the capped unit cylinder
+// (radius 0.5 around y, height 1) of HandRenderer in model space and
+// writes the exact depth of the hit.
+
+noperspective in vec4 ray_near;
+noperspective in vec4 ray_far;
+flat in mat4 transform;
+
+uniform bool bCylinder;
+uniform vec3 color_in;
+out vec3 color;
+
+// nearest hit in front of the ray origin, negative on a miss
+float IntersectSphere(vec3 o, vec3 d) {
+	float a = dot(d, d);
+	float b = dot(o, d);
+	float c = dot(o, o) - 0.25;
+	float disc = b*b - a*c;
+	if(disc < 0.0)
+		return -1.0;
+
+	float root = sqrt(disc);
+	float t = (-b - root) / a;
+	return (t >= 0.0) ? t : (-b + root) / a;
+}
+
+float IntersectCylinder(vec3 o, vec3 d) {
+	float tHit = -1.0;
+
+	// mantle
+	float a = d.x*d.x + d.z*d.z;
+	float b = o.x*d.x + o.z*d.z;
+	float c = o.x*o.x + o.z*o.z - 0.25;
+	float disc = b*b - a*c;
+	if(a > 0.0 && disc >= 0.0) {
+		float root = sqrt(disc);
+		for(int i = 0; i < 2; ++i) {
+			float t = (-b + (i == 0 ? -root : root)) / a;
+			float y = o.y + t*d.y;
+			if(t >= 0.0 && abs(y) <= 0.5 && (tHit < 0.0 || t < tHit))
+				tHit = t;
+		}
+	}
+
+	// caps
+	if(d.y != 0.0) {
+		for(int i = 0; i < 2; ++i) {
+			float t = ((i == 0 ? -0.5 : 0.5) - o.y) / d.y;
+			vec2 p = o.xz + t*d.xz;
+			if(t >= 0.0 && dot(p, p) <= 0.25 && (tHit < 0.0 || t < tHit))
+				tHit = t;
+		}
+	}
+
+	return tHit;
+}
+
+void main(){
+	vec3 o = ray_near.xyz / ray_near.w;
+	vec3 d = ray_far.xyz / ray_far.w - o;
+
+	float t = bCylinder ? IntersectCylinder(o, d) : IntersectSphere(o, d);
+	if(t < 0.0 || t > 1.0)
+		discard;
+
+	vec4 vClip = transform * vec4(o + t*d, 1.0);
+	float fNDC = vClip.z / vClip.w;
+	gl_FragDepth = 0.5*(gl_DepthRange.diff*fNDC +
+						gl_DepthRange.near + gl_DepthRange.far);
+
+	color = color_in;
+}
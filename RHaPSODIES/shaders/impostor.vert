@@ -0,0 +1,38 @@
+#version 430 compatibility
+
+// one point per primitive instance, impostor.geom expands it to a
+// screen aligned quad
+
+out int instance_id;
+out mat4 instance_transform;
+out int instance_valid;
+
+uniform uint transform_offset;
+
+#ifdef STATE_TRANSFORMS
+// see vpos_indexedtransform.vert
+uniform bool bCylinder;
+uniform uint cylinder_base;
+
+mat4 InstanceTransform(uint instance, bool bCylinder);
+#else
+layout(std430, binding = 2) buffer TransformBlock {
+  mat4 model_transform[];
+};
+#endif
+
+void main(){
+#ifdef STATE_TRANSFORMS
+	uint instance = gl_InstanceID + transform_offset;
+	mat4 model = InstanceTransform(
+		bCylinder ? instance - cylinder_base : instance, bCylinder);
+#else
+	mat4 model = model_transform[gl_InstanceID + transform_offset];
+#endif
+
+	instance_id = gl_InstanceID;
+	instance_transform = gl_ModelViewProjectionMatrix * model;
+	// padding instances carry a zero matrix
+	instance_valid = (determinant(mat3(model)) != 0.0) ? 1 : 0;
+	gl_Position = vec4(0, 0, 0, 1);
+}
@@ -1,16 +1,33 @@
 #version 430 compatibility
 
+#ifdef LAYERED
+// one depth layer per particle, selected without a geometry shader
+#extension GL_ARB_shader_viewport_layer_array : enable
+#extension GL_AMD_vertex_shader_layer : enable
+#endif
+
 out int instance_id;
 
 uniform uint transform_offset;
 
-const int ARRAY_SIZE = 4864; // 64*2*(22+16)
+#ifdef STATE_TRANSFORMS
+// spheres or cylinders, the latter start at cylinder_base
+uniform bool bCylinder;
+uniform uint cylinder_base;
 
+mat4 InstanceTransform(uint instance, bool bCylinder);
+#else
 layout(std430, binding = 2) buffer TransformBlock {
-  mat4 model_transform[ARRAY_SIZE];
+  mat4 model_transform[];
 };
+#endif
+
+// the whole swarm is drawn in one call with layered targets, see
+// HandTracker::RenderSwarm()
+uniform int instances_per_viewport;
 
-// uniform int instances_per_viewport;
+float SplitClipDistance(int instance, int instances_per_viewport,
+						vec4 position);
 
 layout(location=0) in vec3 vertexPosition_modelspace;
 
@@ -21,7 +38,18 @@ void main(){
 	// gl_ViewportIndex = gl_InstanceID / instances_per_viewport;
 
 	instance_id = gl_InstanceID;
-	gl_Position = gl_ModelViewProjectionMatrix *
-		model_transform[gl_InstanceID + transform_offset] *
+#ifdef LAYERED
+	gl_Layer = gl_InstanceID / instances_per_viewport;
+#endif
+#ifdef STATE_TRANSFORMS
+	uint instance = gl_InstanceID + transform_offset;
+	mat4 model = InstanceTransform(
+		bCylinder ? instance - cylinder_base : instance, bCylinder);
+#else
+	mat4 model = model_transform[gl_InstanceID + transform_offset];
+#endif
+	gl_Position = gl_ModelViewProjectionMatrix * model *
 		vec4(vertexPosition_modelspace,1);
+	gl_ClipDistance[0] = SplitClipDistance(
+		gl_InstanceID, instances_per_viewport, gl_Position);
 }
@@ -2,11 +2,10 @@
 
 out int instance_id;
 
-const int ARRAY_SIZE = 4864; // 64*2*(22+16)
 uniform uint transform_offset;
 
 layout (std430, binding = 2) buffer TransformBlock {
-  mat4 model_transform[ARRAY_SIZE];
+  mat4 model_transform[];
 };
 
 layout(location = 0) in vec3 vertexPosition_modelspace;
@@ -14,6 +14,10 @@ namespace rhapsodies {
 			RENDER_TIME,			
 			REDUCTION_TIME,			
 			SWARMUPDATE_TIME,			
+			GENERATION_TIME,
+			GPU_FRAME_TIME,
+			RENDER_FRAGMENTS,
+			PSO_GENERATIONS,
 			PSO_TIME,
 			LOOP_TIME,
 			LOOP_FPS,
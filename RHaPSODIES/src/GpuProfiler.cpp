@@ -0,0 +1,355 @@
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+#include <GL/glew.h>
+
+#include <VistaBase/VistaStreamUtils.h>
+
+#include "GpuProfiler.hpp"
+
+namespace {
+	using rhapsodies::GpuProfiler;
+
+	// query pool 0 holds timestamps, pool 1+c the queries of counter c
+	const size_t iTimestampPool = 0;
+	const size_t iPoolCount = 1 + GpuProfiler::COUNTER_LAST;
+
+	const GLenum aCounterTargets[GpuProfiler::COUNTER_LAST] = {
+		GL_VERTICES_SUBMITTED_ARB,
+		GL_PRIMITIVES_SUBMITTED_ARB,
+		GL_FRAGMENT_SHADER_INVOCATIONS_ARB
+	};
+
+	bool GetQueryAvailable(GLuint idQuery) {
+		GLuint iAvailable = GL_FALSE;
+		glGetQueryObjectuiv(idQuery, GL_QUERY_RESULT_AVAILABLE, &iAvailable);
+		return iAvailable == GL_TRUE;
+	}
+
+	GLuint64 GetQueryResult(GLuint idQuery) {
+		GLuint64 iResult = 0;
+		glGetQueryObjectui64v(idQuery, GL_QUERY_RESULT, &iResult);
+		return iResult;
+	}
+}
+
+namespace rhapsodies {
+	GpuProfiler::Summary::Summary() :
+		iSamples(0),
+		dMin(0.0),
+		dMean(0.0),
+		dP99(0.0) {
+	}
+
+	GpuProfiler::GpuProfiler(size_t iHistoryLength) :
+		m_iHistoryLength(std::max(iHistoryLength, size_t(1))),
+		m_bPipelineStatistics(GLEW_ARB_pipeline_statistics_query),
+		m_iCurrentFrame(0),
+		m_iSkippedFrames(0) {
+
+		for(size_t i = 0; i < 2; ++i) {
+			m_aFrames[i].vecPools.resize(iPoolCount);
+			m_aFrames[i].vecPoolUsed.resize(iPoolCount, 0);
+		}
+		for(size_t stage = 0; stage < STAGE_LAST; ++stage) {
+			m_aOpenInterval[stage] = -1;
+		}
+
+		if(!m_bPipelineStatistics) {
+			vstr::warn() << "ARB_pipeline_statistics_query not supported, "
+						 << "GPU profile has no vertex, primitive and "
+						 << "fragment counts." << std::endl;
+		}
+	}
+
+	GpuProfiler::~GpuProfiler() {
+		for(size_t i = 0; i < 2; ++i) {
+			for(size_t pool = 0; pool < iPoolCount; ++pool) {
+				std::vector<GLuint> &vecPool = m_aFrames[i].vecPools[pool];
+				if(!vecPool.empty())
+					glDeleteQueries(GLsizei(vecPool.size()), &vecPool[0]);
+			}
+		}
+	}
+
+	void GpuProfiler::BeginStage(Stage eStage) {
+		FrameQueries &oFrame = m_aFrames[m_iCurrentFrame];
+
+		Interval oInterval;
+		oInterval.eStage = eStage;
+		oInterval.idBegin = AcquireQuery(iTimestampPool);
+		oInterval.idEnd = 0;
+		for(size_t counter = 0; counter < COUNTER_LAST; ++counter) {
+			oInterval.idCounters[counter] = 0;
+		}
+
+		glQueryCounter(oInterval.idBegin, GL_TIMESTAMP);
+
+		// begin/end queries of a target may not overlap, only the
+		// render stage is counted
+		if(eStage == RENDER && m_bPipelineStatistics) {
+			for(size_t counter = 0; counter < COUNTER_LAST; ++counter) {
+				oInterval.idCounters[counter] = AcquireQuery(1 + counter);
+				glBeginQuery(aCounterTargets[counter],
+							 oInterval.idCounters[counter]);
+			}
+		}
+
+		m_aOpenInterval[eStage] = int(oFrame.vecIntervals.size());
+		oFrame.vecIntervals.push_back(oInterval);
+	}
+
+	void GpuProfiler::EndStage(Stage eStage) {
+		if(m_aOpenInterval[eStage] < 0) {
+			vstr::warn() << "GPU profiler stage " << GetStageName(eStage)
+						 << " ended without being started." << std::endl;
+			return;
+		}
+
+		FrameQueries &oFrame = m_aFrames[m_iCurrentFrame];
+		Interval &oInterval = oFrame.vecIntervals[m_aOpenInterval[eStage]];
+		m_aOpenInterval[eStage] = -1;
+
+		if(oInterval.idCounters[0]) {
+			for(size_t counter = 0; counter < COUNTER_LAST; ++counter) {
+				glEndQuery(aCounterTargets[counter]);
+			}
+		}
+
+		oInterval.idEnd = AcquireQuery(iTimestampPool);
+		glQueryCounter(oInterval.idEnd, GL_TIMESTAMP);
+	}
+
+	void GpuProfiler::EndFrame() {
+		for(size_t stage = 0; stage < STAGE_LAST; ++stage) {
+			if(m_aOpenInterval[stage] >= 0) {
+				EndStage(Stage(stage));
+			}
+		}
+
+		// the other buffer holds the queries of the previous frame,
+		// they are reused by the next one
+		m_iCurrentFrame = 1 - m_iCurrentFrame;
+		Collect(m_aFrames[m_iCurrentFrame]);
+	}
+
+	bool GpuProfiler::GetHasPipelineStatistics() const {
+		return m_bPipelineStatistics;
+	}
+
+	size_t GpuProfiler::GetSkippedFrameCount() const {
+		return m_iSkippedFrames;
+	}
+
+	GpuProfiler::Summary GpuProfiler::GetStageSummary(Stage eStage) const {
+		return Summarize(m_aStageHistory[eStage]);
+	}
+
+	GpuProfiler::Summary GpuProfiler::GetCounterSummary(
+		Counter eCounter) const {
+		return Summarize(m_aCounterHistory[eCounter]);
+	}
+
+	std::string GpuProfiler::GetStageName(Stage eStage) {
+		switch(eStage) {
+		case FRAME:        return "Frame";
+		case GENERATION:   return "Generation";
+		case TRANSFORM:    return "Transform";
+		case RENDER:       return "Render";
+		case REDUCTION:    return "Reduction";
+		case SWARM_UPDATE: return "Swarm update";
+		case REFINEMENT:   return "Refinement";
+		default:           return "Unknown";
+		}
+	}
+
+	std::string GpuProfiler::GetCounterName(Counter eCounter) {
+		switch(eCounter) {
+		case VERTICES:   return "Vertices";
+		case PRIMITIVES: return "Primitives";
+		case FRAGMENTS:  return "Fragments";
+		default:         return "Unknown";
+		}
+	}
+
+	std::string GpuProfiler::FormatStage(Stage eStage) const {
+		Summary oSummary = GetStageSummary(eStage);
+
+		std::ostringstream ostr;
+		ostr << std::fixed << std::setprecision(3)
+			 << 1e3*oSummary.dMean << " ms ("
+			 << 1e3*oSummary.dMin << ", p99 "
+			 << 1e3*oSummary.dP99 << ")";
+		return ostr.str();
+	}
+
+	std::string GpuProfiler::FormatCounter(Counter eCounter) const {
+		Summary oSummary = GetCounterSummary(eCounter);
+
+		std::ostringstream ostr;
+		ostr << std::fixed << std::setprecision(0)
+			 << oSummary.dMean << " ("
+			 << oSummary.dMin << ", p99 "
+			 << oSummary.dP99 << ")";
+		return ostr.str();
+	}
+
+	void GpuProfiler::PrintReport(std::ostream &out) const {
+		out << "GPU profile, mean (min, p99) over the last "
+			<< m_iHistoryLength << " samples:" << std::endl;
+		if(m_iSkippedFrames > 0) {
+			out << std::setw(16) << "Skipped" << ": "
+				<< m_iSkippedFrames << " frames not yet finished by the gpu"
+				<< std::endl;
+		}
+
+		for(size_t stage = 0; stage < STAGE_LAST; ++stage) {
+			Summary oSummary = GetStageSummary(Stage(stage));
+			if(oSummary.iSamples == 0)
+				continue;
+
+			out << std::setw(16) << GetStageName(Stage(stage)) << ": "
+				<< FormatStage(Stage(stage))
+				<< (stage == GENERATION ? " per generation" : " per frame")
+				<< std::endl;
+		}
+
+		if(!m_bPipelineStatistics)
+			return;
+
+		for(size_t counter = 0; counter < COUNTER_LAST; ++counter) {
+			out << std::setw(16) << GetCounterName(Counter(counter)) << ": "
+				<< FormatCounter(Counter(counter)) << " per frame"
+				<< std::endl;
+		}
+	}
+
+	GLuint GpuProfiler::AcquireQuery(size_t iPool) {
+		FrameQueries &oFrame = m_aFrames[m_iCurrentFrame];
+		std::vector<GLuint> &vecPool = oFrame.vecPools[iPool];
+		size_t &iUsed = oFrame.vecPoolUsed[iPool];
+
+		if(iUsed == vecPool.size()) {
+			GLuint idQuery;
+			glGenQueries(1, &idQuery);
+			vecPool.push_back(idQuery);
+		}
+
+		return vecPool[iUsed++];
+	}
+
+	void GpuProfiler::Collect(FrameQueries &oFrame) {
+		double aStageTotal[STAGE_LAST];
+		bool aStageSeen[STAGE_LAST];
+		for(size_t stage = 0; stage < STAGE_LAST; ++stage) {
+			aStageTotal[stage] = 0.0;
+			aStageSeen[stage] = false;
+		}
+
+		GLuint64 aCounterTotal[COUNTER_LAST] = { 0 };
+		bool bCounted = false;
+
+		// results of the previous frame are usually available. If the
+		// gpu lags behind, the frame is skipped rather than waited
+		// for, its queries are reused by the next frame.
+		if(!GetIsAvailable(oFrame)) {
+			m_iSkippedFrames++;
+			oFrame.vecIntervals.clear();
+			std::fill(oFrame.vecPoolUsed.begin(),
+					  oFrame.vecPoolUsed.end(), 0);
+			return;
+		}
+
+		for(auto &oInterval : oFrame.vecIntervals) {
+			if(oInterval.idEnd == 0)
+				continue;
+
+			GLuint64 iBegin = GetQueryResult(oInterval.idBegin);
+			GLuint64 iEnd   = GetQueryResult(oInterval.idEnd);
+			double dTime = 1e-9*double(iEnd - iBegin);
+
+			if(oInterval.eStage == GENERATION) {
+				AddSample(m_aStageHistory[GENERATION], dTime);
+			}
+			else {
+				aStageTotal[oInterval.eStage] += dTime;
+				aStageSeen[oInterval.eStage] = true;
+			}
+
+			if(oInterval.idCounters[0]) {
+				for(size_t counter = 0; counter < COUNTER_LAST; ++counter) {
+					aCounterTotal[counter] +=
+						GetQueryResult(oInterval.idCounters[counter]);
+				}
+				bCounted = true;
+			}
+		}
+
+		for(size_t stage = 0; stage < STAGE_LAST; ++stage) {
+			if(aStageSeen[stage])
+				AddSample(m_aStageHistory[stage], aStageTotal[stage]);
+		}
+		if(bCounted) {
+			for(size_t counter = 0; counter < COUNTER_LAST; ++counter) {
+				AddSample(m_aCounterHistory[counter],
+						  double(aCounterTotal[counter]));
+			}
+		}
+
+		oFrame.vecIntervals.clear();
+		std::fill(oFrame.vecPoolUsed.begin(), oFrame.vecPoolUsed.end(), 0);
+	}
+
+	bool GpuProfiler::GetIsAvailable(const FrameQueries &oFrame) const {
+		for(auto &oInterval : oFrame.vecIntervals) {
+			if(oInterval.idEnd == 0)
+				continue;
+
+			if(!GetQueryAvailable(oInterval.idBegin) ||
+			   !GetQueryAvailable(oInterval.idEnd))
+				return false;
+
+			if(oInterval.idCounters[0]) {
+				for(size_t counter = 0; counter < COUNTER_LAST; ++counter) {
+					if(!GetQueryAvailable(oInterval.idCounters[counter]))
+						return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	void GpuProfiler::AddSample(std::deque<double> &deqHistory,
+								double dValue) {
+		deqHistory.push_back(dValue);
+		if(deqHistory.size() > m_iHistoryLength)
+			deqHistory.pop_front();
+	}
+
+	GpuProfiler::Summary GpuProfiler::Summarize(
+		const std::deque<double> &deqHistory) const {
+		Summary oSummary;
+		if(deqHistory.empty())
+			return oSummary;
+
+		std::vector<double> vecSorted(deqHistory.begin(), deqHistory.end());
+		std::sort(vecSorted.begin(), vecSorted.end());
+
+		double dSum = 0.0;
+		for(double dValue : vecSorted) {
+			dSum += dValue;
+		}
+
+		size_t iP99 = size_t(std::ceil(0.99*double(vecSorted.size())));
+
+		oSummary.iSamples = vecSorted.size();
+		oSummary.dMin  = vecSorted.front();
+		oSummary.dMean = dSum / double(vecSorted.size());
+		oSummary.dP99  = vecSorted[std::max(iP99, size_t(1)) - 1];
+
+		return oSummary;
+	}
+}
@@ -0,0 +1,126 @@
+#ifndef _RHAPSODIES_GPUPROFILER
+#define _RHAPSODIES_GPUPROFILER
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <ostream>
+
+#include <GL/gl.h>
+
+namespace rhapsodies {
+	/**
+	 * GPU side timing of the tracker stages. Each stage is enclosed
+	 * in GL_TIMESTAMP queries, the render stage additionally in
+	 * ARB_pipeline_statistics_query counters if available. Queries
+	 * are double buffered per frame and collected at the end of the
+	 * following frame, so the CPU does not wait for the GPU. Frames
+	 * whose results are not available by then are skipped.
+	 *
+	 * Stage times are summed up per frame, generations are kept
+	 * one by one. Summaries cover the last iHistoryLength samples.
+	 */
+	class GpuProfiler {
+	public:
+		enum Stage {
+			FRAME,
+			GENERATION,
+			TRANSFORM,
+			RENDER,
+			REDUCTION,
+			SWARM_UPDATE,
+			REFINEMENT,
+			STAGE_LAST
+		};
+
+		enum Counter {
+			VERTICES,
+			PRIMITIVES,
+			FRAGMENTS,
+			COUNTER_LAST
+		};
+
+		struct Summary {
+			Summary();
+
+			size_t iSamples;
+			double dMin;
+			double dMean;
+			double dP99;
+		};
+
+		GpuProfiler(size_t iHistoryLength);
+		~GpuProfiler();
+
+		void BeginStage(Stage eStage);
+		void EndStage(Stage eStage);
+
+		/**
+		 * Swaps the query buffers and collects the results of the
+		 * previous frame.
+		 */
+		void EndFrame();
+
+		bool GetHasPipelineStatistics() const;
+
+		/**
+		 * Frames dropped because their queries had no result yet.
+		 */
+		size_t GetSkippedFrameCount() const;
+
+		/**
+		 * Stage times in seconds.
+		 */
+		Summary GetStageSummary(Stage eStage) const;
+		Summary GetCounterSummary(Counter eCounter) const;
+
+		static std::string GetStageName(Stage eStage);
+		static std::string GetCounterName(Counter eCounter);
+
+		/**
+		 * Compact "mean (min, p99)" line in milliseconds.
+		 */
+		std::string FormatStage(Stage eStage) const;
+		std::string FormatCounter(Counter eCounter) const;
+
+		void PrintReport(std::ostream &out) const;
+
+	private:
+		struct Interval {
+			Stage eStage;
+			GLuint idBegin;
+			GLuint idEnd;
+			// pipeline statistics, render stage only
+			GLuint idCounters[COUNTER_LAST];
+		};
+
+		// query objects keep their target, so each target has its
+		// own pool
+		struct FrameQueries {
+			std::vector<std::vector<GLuint> > vecPools;
+			std::vector<size_t> vecPoolUsed;
+			std::vector<Interval> vecIntervals;
+		};
+
+		GLuint AcquireQuery(size_t iPool);
+		bool GetIsAvailable(const FrameQueries &oFrame) const;
+		void Collect(FrameQueries &oFrame);
+		void AddSample(std::deque<double> &deqHistory, double dValue);
+		Summary Summarize(const std::deque<double> &deqHistory) const;
+
+		size_t m_iHistoryLength;
+		bool m_bPipelineStatistics;
+
+		FrameQueries m_aFrames[2];
+		size_t m_iCurrentFrame;
+		size_t m_iSkippedFrames;
+
+		// open interval per stage, stages of one kind do not nest
+		int m_aOpenInterval[STAGE_LAST];
+
+		std::deque<double> m_aStageHistory[STAGE_LAST];
+		std::deque<double> m_aCounterHistory[COUNTER_LAST];
+	};
+}
+
+#endif // _RHAPSODIES_GPUPROFILER
@@ -0,0 +1,73 @@
+#include "Halton.hpp"
+
+namespace {
+	typedef rhapsodies::Halton::uint32 uint32;
+
+	// has to match halton.part
+	const uint32 aPrimes[rhapsodies::Halton::iDimensionCount] = {
+		  2,   3,   5,   7,  11,  13,  17,  19,  23,  29,  31,  37,  41,  43,
+		 47,  53,  59,  61,  67,  71,  73,  79,  83,  89,  97, 101, 103, 107,
+		109, 113, 127, 131, 137, 139, 149, 151, 157, 163, 167, 173, 179, 181,
+		191, 193, 197, 199, 211, 223, 227, 229, 233, 239, 241, 251, 257, 263,
+		269, 271, 277, 281, 283, 293, 307, 311
+	};
+}
+
+namespace rhapsodies {
+	namespace Halton {
+		uint32 GetBase(size_t iDimension) {
+			return aPrimes[iDimension];
+		}
+
+		int GetStateDimension(size_t iStateDim) {
+			using namespace HandStateLayout;
+
+			size_t iHand   = iStateDim / iHandStride;
+			size_t iOffset = iStateDim % iHandStride;
+
+			// the global pose gets the lowest bases, then the joints.
+			// position w and padding are not searched.
+			const size_t iPositionDofs = iPositionSize - 1;
+			size_t iDof;
+			if(iOffset >= iPositionOffset &&
+			   iOffset < iPositionOffset + iPositionDofs)
+				iDof = iOffset - iPositionOffset;
+			else if(iOffset >= iOrientationOffset &&
+					iOffset < iOrientationOffset + iOrientationSize)
+				iDof = iPositionDofs + iOffset - iOrientationOffset;
+			else if(iOffset >= iJointOffset &&
+					iOffset < iJointOffset + iJointCount)
+				iDof = iPositionDofs + iOrientationSize + iOffset - iJointOffset;
+			else
+				return -1;
+
+			return int(iDof*iHandCount + iHand);
+		}
+
+		float Sample(uint32 iIndex, uint32 iDimension, uint32 nPoints,
+					 uint32 iFrame, uint32 iPass, uint32 iSeed,
+					 float fJitter) {
+			const uint32 iBase = aPrimes[iDimension];
+			const uint32 aKey[2] = { iSeed, Philox::STREAM_HALTON_SCRAMBLE };
+
+			// digits are reversed into the numerator, most
+			// significant first
+			uint32 iNumerator = 0;
+			uint32 iDenominator = 1;
+			for(uint32 iDigit = 0; iDenominator < nPoints; ++iDigit) {
+				const uint32 aCounter[4] = { iFrame, iPass, iDimension, iDigit };
+				uint32 aResult[4];
+				Philox::Generate(aCounter, aKey, aResult);
+
+				uint32 a = 1 + aResult[0] % (iBase - 1);
+				uint32 c = aResult[1] % iBase;
+
+				iNumerator = iNumerator*iBase + (a*(iIndex % iBase) + c) % iBase;
+				iDenominator *= iBase;
+				iIndex /= iBase;
+			}
+
+			return (float(iNumerator) + fJitter) / float(iDenominator);
+		}
+	}
+}
@@ -0,0 +1,50 @@
+#ifndef _RHAPSODIES_HALTON
+#define _RHAPSODIES_HALTON
+
+#include <cstddef>
+
+#include "HandStateLayout.hpp"
+#include "Philox.hpp"
+
+namespace rhapsodies {
+	/**
+	 * Scrambled Halton sequence for spreading a swarm of nPoints
+	 * particles. Each dimension uses its own prime base, the digits
+	 * of the point index are permuted by d -> (a*d + c) mod base
+	 * with a and c drawn from the Philox stream
+	 * STREAM_HALTON_SCRAMBLE, so every frame gets a fresh point set
+	 * that keeps the stratification of the plain sequence. A jitter
+	 * value fills the precision below the finest stratum.
+	 * shaders/halton.part is the GLSL counterpart, equal up to float
+	 * rounding.
+	 */
+	namespace Halton {
+		typedef Philox::uint32 uint32;
+
+		const size_t iDimensionCount = 64;
+
+		static_assert(iDimensionCount >= HandStateLayout::iDofCount,
+					  "not enough halton bases for the hand state");
+
+		uint32 GetBase(size_t iDimension);
+
+		/**
+		 * Halton dimension of a particle state dimension, -1 for
+		 * dimensions that are not searched. Position and orientation
+		 * come first and the hands are interleaved, so the global
+		 * pose of both hands gets the low bases.
+		 */
+		int GetStateDimension(size_t iStateDim);
+
+		/**
+		 * Coordinate of point iIndex < nPoints in [0, 1). iFrame and
+		 * iPass select the scrambling, fJitter in [0, 1) the
+		 * position within the point's stratum.
+		 */
+		float Sample(uint32 iIndex, uint32 iDimension, uint32 nPoints,
+					 uint32 iFrame, uint32 iPass, uint32 iSeed,
+					 float fJitter);
+	}
+}
+
+#endif // _RHAPSODIES_HALTON
@@ -9,9 +9,9 @@ namespace rhapsodies {
 	const int iRandomAngleMax = 40;
 	const int iRandomAngleAbdMinMax = 10;
 	
-	HandModel::HandModel() :
-		m_vecJointAngles(20, 0)
-	{}
+	HandModel::HandModel() {
+		m_arJointAngles.fill(0);
+	}
 
 	void HandModel::SetPosition(const VistaVector3D &vPos) {
 		m_vPosition = vPos;
@@ -39,15 +39,15 @@ namespace rhapsodies {
 	}
 	
 	float HandModel::GetJointAngle(size_t eDOF) {
-		return m_vecJointAngles[eDOF];
+		return m_arJointAngles[eDOF];
 	}
 
-	std::vector<float>& HandModel::GetJointAngles() {
-		return m_vecJointAngles;
+	HandModel::JointAngleArray& HandModel::GetJointAngles() {
+		return m_arJointAngles;
 	}
 
 	void HandModel::SetJointAngle(size_t eDOF, float fAngleDegrees) {
-		m_vecJointAngles[eDOF] = fAngleDegrees;
+		m_arJointAngles[eDOF] = fAngleDegrees;
 	}
 
 	void HandModel::Randomize() {
@@ -87,36 +87,35 @@ namespace rhapsodies {
 	}
 
 	void HandModel::HandModelToStateArray(HandModel *pModel, float *aState) {
-		for(size_t dof = 0; dof < 20; ++dof) {
-			aState[ 0+dof] = pModel->GetJointAngle(dof);
+		using namespace HandStateLayout;
+
+		for(size_t dof = 0; dof < iJointCount; ++dof) {
+			aState[iJointOffset+dof] = pModel->m_arJointAngles[dof];
 		}
 
-		VistaVector3D vPos = pModel->GetPosition();
-		for(size_t dim = 0; dim < 4; ++dim) {
-			aState[20+dim] = vPos[dim];
+		for(size_t dim = 0; dim < iPositionSize; ++dim) {
+			aState[iPositionOffset+dim] = pModel->m_vPosition[dim];
 		}
 
-		VistaQuaternion qOri = pModel->GetOrientation();
-		for(size_t dim = 0; dim < 4; ++dim) {
-			aState[24+dim] = qOri[dim];
+		for(size_t dim = 0; dim < iOrientationSize; ++dim) {
+			aState[iOrientationOffset+dim] = pModel->m_qOrientation[dim];
 		}
 	}
 
-	void HandModel::StateArrayToHandModel(HandModel *pModel, float *aState) {
-		for(size_t dof = 0; dof < 20; ++dof) {
-			pModel->SetJointAngle(dof, aState[dof]);
+	void HandModel::StateArrayToHandModel(HandModel *pModel,
+										  const float *aState) {
+		using namespace HandStateLayout;
+
+		for(size_t dof = 0; dof < iJointCount; ++dof) {
+			pModel->m_arJointAngles[dof] = aState[iJointOffset+dof];
 		}
 
-		VistaVector3D vPos;
-		for(size_t dim = 0; dim < 4; ++dim) {
-			vPos[dim] = aState[20+dim];
+		for(size_t dim = 0; dim < iPositionSize; ++dim) {
+			pModel->m_vPosition[dim] = aState[iPositionOffset+dim];
 		}
-		pModel->SetPosition(vPos);
 
-		VistaQuaternion qOri;
-		for(size_t dim = 0; dim < 4; ++dim) {
-			qOri[dim] = aState[24+dim];
+		for(size_t dim = 0; dim < iOrientationSize; ++dim) {
+			pModel->m_qOrientation[dim] = aState[iOrientationOffset+dim];
 		}
-		pModel->SetOrientation(qOri);
 	}
 }
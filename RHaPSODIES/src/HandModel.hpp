@@ -1,14 +1,18 @@
 #ifndef _RHAPSODIES_HANDMODEL
 #define _RHAPSODIES_HANDMODEL
 
-#include <vector>
+#include <array>
 
 #include <VistaBase/VistaVector3D.h>
 #include <VistaBase/VistaQuaternion.h>
 
+#include "HandStateLayout.hpp"
+
 namespace rhapsodies {
   class HandModel {
   public:
+	  typedef std::array<float, HandStateLayout::iJointCount> JointAngleArray;
+
 	  HandModel();
 
 	  /**
@@ -78,7 +82,7 @@ namespace rhapsodies {
 	   * @return Angle in degrees.
 	   */
 	  float GetJointAngle(size_t eDOF);
-	  std::vector<float>& GetJointAngles();
+	  JointAngleArray& GetJointAngles();
 
 	  /**
 	   * Set a skeleton joint angle in degrees.
@@ -93,8 +97,12 @@ namespace rhapsodies {
 	   */
 	  void Randomize();
 
+	  /**
+	   * Convert from/to a single hand block of the flat particle
+	   * state, see HandStateLayout.
+	   */
 	  static void HandModelToStateArray(HandModel *model, float *aState);
-	  static void StateArrayToHandModel(HandModel *model, float *aState);
+	  static void StateArrayToHandModel(HandModel *model, const float *aState);
 	  
   private:
 	  VistaVector3D   m_vPosition;
@@ -102,8 +110,11 @@ namespace rhapsodies {
 
 	  HandType m_eType;
 
-	  std::vector<float> m_vecJointAngles;
+	  JointAngleArray m_arJointAngles;
   };
+
+  static_assert(HandModel::JOINTDOF_LAST == HandStateLayout::iJointCount,
+				"state layout joint count does not match the hand model");
 }
 
 #endif // _RHAPSODIES_HANDMODEL
@@ -1,3 +1,6 @@
+#include <map>
+#include <utility>
+
 #include <GL/glew.h>
 
 #include <VistaBase/VistaStreamUtils.h>
@@ -17,20 +20,192 @@
 
 namespace {
 	const std::string sLogPrefix = "[HandRenderer] ";
+
+	// post transform cache size the index order is tuned for
+	const int iVertexCacheSize = 16;
+
+	// indexed mesh with only the attributes that are drawn, vertices
+	// that only differ in unused attributes are merged
+	struct IndexedMesh {
+		std::vector<float> vCoords;
+		std::vector<float> vNormals;
+		std::vector<GLuint> vIndices;
+	};
+
+	void BuildIndexedMesh(const std::vector<VistaIndexedVertex> &vIndices,
+						  const float *pCoords, const float *pNormals,
+						  bool bNormals, IndexedMesh &oMesh) {
+		std::map<std::pair<int, int>, GLuint> mapVertex;
+
+		for(const VistaIndexedVertex &oVertex: vIndices) {
+			std::pair<int, int> key(oVertex.GetCoordinateIndex(),
+									bNormals ? oVertex.GetNormalIndex() : 0);
+
+			std::map<std::pair<int, int>, GLuint>::iterator it =
+				mapVertex.find(key);
+			if(it == mapVertex.end()) {
+				GLuint index = GLuint(oMesh.vCoords.size()/3);
+				for(int dim = 0 ; dim < 3 ; dim++) {
+					oMesh.vCoords.push_back(pCoords[3*key.first+dim]);
+					if(bNormals)
+						oMesh.vNormals.push_back(pNormals[3*key.second+dim]);
+				}
+				it = mapVertex.insert(std::make_pair(key, index)).first;
+			}
+			oMesh.vIndices.push_back(it->second);
+		}
+	}
+
+	// next fanning vertex of Tipsify, see Sander et al. "Fast
+	// Triangle Reordering for Vertex Locality and Reduced Overdraw"
+	int TipsifyNextVertex(const std::vector<int> &vCandidates,
+						  const std::vector<int> &vLive,
+						  const std::vector<int> &vCacheTime,
+						  int iTime,
+						  std::vector<int> &vDeadEnd,
+						  size_t &iCursor) {
+		int iBest = -1;
+		int iBestPriority = -1;
+		for(int v: vCandidates) {
+			if(vLive[v] == 0)
+				continue;
+
+			// prefer vertices that stay in the cache while their
+			// remaining triangles are emitted
+			int iPriority = 0;
+			if(iTime - vCacheTime[v] + 2*vLive[v] <= iVertexCacheSize)
+				iPriority = iTime - vCacheTime[v];
+			if(iPriority > iBestPriority) {
+				iBestPriority = iPriority;
+				iBest = v;
+			}
+		}
+		if(iBest >= 0)
+			return iBest;
+
+		while(!vDeadEnd.empty()) {
+			int v = vDeadEnd.back();
+			vDeadEnd.pop_back();
+			if(vLive[v] > 0)
+				return v;
+		}
+
+		for( ; iCursor < vLive.size() ; ++iCursor) {
+			if(vLive[iCursor] > 0)
+				return int(iCursor);
+		}
+		return -1;
+	}
+
+	// reorders the triangles for the post transform cache and the
+	// vertices by first use
+	void OptimizeVertexCache(IndexedMesh &oMesh) {
+		size_t iVertices  = oMesh.vCoords.size()/3;
+		size_t iTriangles = oMesh.vIndices.size()/3;
+		if(iTriangles == 0)
+			return;
+
+		std::vector<std::vector<size_t> > vAdjacency(iVertices);
+		std::vector<int> vLive(iVertices, 0);
+		for(size_t t = 0 ; t < iTriangles ; t++) {
+			for(int corner = 0 ; corner < 3 ; corner++) {
+				GLuint v = oMesh.vIndices[3*t+corner];
+				vAdjacency[v].push_back(t);
+				vLive[v]++;
+			}
+		}
+
+		std::vector<int> vCacheTime(iVertices, 0);
+		std::vector<bool> vEmitted(iTriangles, false);
+		std::vector<int> vDeadEnd;
+		std::vector<int> vCandidates;
+		std::vector<GLuint> vIndices;
+		vIndices.reserve(oMesh.vIndices.size());
+
+		int iTime = iVertexCacheSize + 1;
+		size_t iCursor = 0;
+		int f = int(oMesh.vIndices[0]);
+
+		while(f >= 0) {
+			vCandidates.clear();
+			for(size_t t: vAdjacency[f]) {
+				if(vEmitted[t])
+					continue;
+
+				for(int corner = 0 ; corner < 3 ; corner++) {
+					int v = int(oMesh.vIndices[3*t+corner]);
+					vIndices.push_back(GLuint(v));
+					vDeadEnd.push_back(v);
+					vCandidates.push_back(v);
+					vLive[v]--;
+					if(iTime - vCacheTime[v] > iVertexCacheSize) {
+						vCacheTime[v] = iTime;
+						iTime++;
+					}
+				}
+				vEmitted[t] = true;
+			}
+
+			f = TipsifyNextVertex(vCandidates, vLive, vCacheTime, iTime,
+								  vDeadEnd, iCursor);
+		}
+
+		// vertices in order of first use, for the pre transform cache
+		std::vector<GLuint> vRemap(iVertices, GLuint(~0));
+		IndexedMesh oOrdered;
+		for(GLuint &index: vIndices) {
+			if(vRemap[index] == GLuint(~0)) {
+				vRemap[index] = GLuint(oOrdered.vCoords.size()/3);
+				for(int dim = 0 ; dim < 3 ; dim++) {
+					oOrdered.vCoords.push_back(oMesh.vCoords[3*index+dim]);
+					if(!oMesh.vNormals.empty())
+						oOrdered.vNormals.push_back(
+							oMesh.vNormals[3*index+dim]);
+				}
+			}
+			index = vRemap[index];
+		}
+		oOrdered.vIndices.swap(vIndices);
+
+		oMesh = oOrdered;
+	}
+
+	void AppendIndexedMesh(const IndexedMesh &oMesh,
+						   std::vector<float> &vVertexData,
+						   std::vector<float> &vNormalData,
+						   std::vector<GLuint> &vIndexData) {
+		vVertexData.insert(vVertexData.end(),
+						   oMesh.vCoords.begin(), oMesh.vCoords.end());
+		vNormalData.insert(vNormalData.end(),
+						   oMesh.vNormals.begin(), oMesh.vNormals.end());
+		vIndexData.insert(vIndexData.end(),
+						  oMesh.vIndices.begin(), oMesh.vIndices.end());
+	}
 }
 
 namespace rhapsodies {
 	HandRenderer::HandRenderer(GLint idProgram,
 							   bool bDrawNormals,
-							   int iSegments) :
+							   int iSegments,
+							   unsigned int iMaxViewports,
+							   bool bImpostors,
+							   bool bStateTransforms) :
 		m_idProgram(idProgram),
 		m_idTransformBlock(0),
 		m_bDrawNormals(bDrawNormals),
+		m_bImpostors(bImpostors),
+		m_bStateTransforms(bStateTransforms),
+		m_iMaxViewports(iMaxViewports),
+		m_bSplitHands(false),
+		m_fSplitX(0.0f),
+		m_bSplitLeftHandFirst(true),
 		m_szSphereData(0),
-		m_szCylinderData(0) {
+		m_szCylinderData(0),
+		m_iSphereVertices(0),
+		m_idSSBOTransforms(0) {
 
-		m_vSphereTransforms.reserve(22*16*2);
-		m_vCylinderTransforms.reserve(15*16*2);
+		m_vSphereTransforms.reserve(22*2*m_iMaxViewports);
+		m_vCylinderTransforms.reserve(16*2*m_iMaxViewports);
 
 		std::vector<VistaIndexedVertex> vIndices;
 		std::vector<VistaVector3D> vCoords;
@@ -46,20 +221,30 @@ namespace rhapsodies {
 			0.5f, 0.5f, 0.5f,
 			iSegments, iSegments);
 
-		// generate vertex list from indices
-		std::vector<VistaIndexedVertex>::iterator it;
-		for( it = vIndices.begin() ; it != vIndices.end() ; ++it ) {
-			for( int dim = 0 ; dim < 3 ; dim++ ) {
-				m_vVertexData.push_back(
-					vCoords[it->GetCoordinateIndex()][dim]);
-				m_vNormalData.push_back(
-					vNormals[it->GetNormalIndex()][dim]);
-			}
+		for(const VistaVector3D &v3Coord: vCoords) {
+			for(int dim = 0 ; dim < 3 ; dim++)
+				vCoordsFloat.push_back(v3Coord[dim]);
+		}
+		for(const VistaVector3D &v3Normal: vNormals) {
+			for(int dim = 0 ; dim < 3 ; dim++)
+				vNormalsFloat.push_back(v3Normal[dim]);
 		}
-		m_szSphereData = vIndices.size();
+
+		// the depth only tracking pass draws positions only, so the
+		// meshes are indexed on the drawn attributes
+		IndexedMesh oSphere;
+		BuildIndexedMesh(vIndices, vCoordsFloat.data(), vNormalsFloat.data(),
+						 m_bDrawNormals, oSphere);
+		OptimizeVertexCache(oSphere);
+		AppendIndexedMesh(oSphere, m_vVertexData, m_vNormalData,
+						  m_vIndexData);
+		m_szSphereData = oSphere.vIndices.size();
+		m_iSphereVertices = oSphere.vCoords.size()/3;
 
 		vIndices.clear();
 		vColors.clear();
+		vCoordsFloat.clear();
+		vNormalsFloat.clear();
 		VistaGeometryFactory::CreateConeData(
 			&vIndices, &vCoordsFloat, &vTexCoordsFloat,
 			&vNormalsFloat, &vColors,
@@ -67,16 +252,13 @@ namespace rhapsodies {
 			iSegments, 1, 1
 			);
 
-		// generate vertex list from indices
-		for( it = vIndices.begin() ; it != vIndices.end() ; ++it ) {
-			for( size_t dim = 0 ; dim < 3 ; dim++ ) {
-				m_vVertexData.push_back(
-					vCoordsFloat[3*it->GetCoordinateIndex()+dim]);
-				m_vNormalData.push_back(
-					vNormalsFloat[3*it->GetNormalIndex()+dim]);
-			}
-		}
-		m_szCylinderData = vIndices.size();
+		IndexedMesh oCylinder;
+		BuildIndexedMesh(vIndices, vCoordsFloat.data(), vNormalsFloat.data(),
+						 m_bDrawNormals, oCylinder);
+		OptimizeVertexCache(oCylinder);
+		AppendIndexedMesh(oCylinder, m_vVertexData, m_vNormalData,
+						  m_vIndexData);
+		m_szCylinderData = oCylinder.vIndices.size();
 
 		PrepareBufferObjects();
 
@@ -88,6 +270,16 @@ namespace rhapsodies {
 			m_idProgram, "instances_per_viewport");
 		m_locTransformOffset = glGetUniformLocation(
 			m_idProgram, "transform_offset");
+		m_locCylinderUniform = glGetUniformLocation(
+			m_idProgram, "bCylinder");
+		m_locCylinderBaseUniform = glGetUniformLocation(
+			m_idProgram, "cylinder_base");
+		m_locSplitHandsUniform = glGetUniformLocation(
+			m_idProgram, "bSplitHands");
+		m_locSplitXUniform = glGetUniformLocation(
+			m_idProgram, "fSplitX");
+		m_locSplitLeftHandFirstUniform = glGetUniformLocation(
+			m_idProgram, "bSplitLeftHandFirst");
 
 	}
 
@@ -95,8 +287,9 @@ namespace rhapsodies {
 
 		// generate vertex array object names
 		glGenVertexArrays(1, &m_idVertexArrayObject);
-		// generate vertex buffer object names
+		// generate vertex and element buffer object names
 		glGenBuffers(1, &m_idVertexBufferObject);
+		glGenBuffers(1, &m_idElementBufferObject);
 
 		// set vertex attrib pointer for sphere and fill with static
 		// data
@@ -112,28 +305,45 @@ namespace rhapsodies {
 						0,
 						sizeof(float)*m_vVertexData.size(),
 						&m_vVertexData[0]);
-		glBufferSubData(GL_ARRAY_BUFFER,
-						sizeof(float)*m_vVertexData.size(),
-						sizeof(float)*m_vNormalData.size(),
-						&m_vNormalData[0]);
 		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0,
-							  (const GLvoid*)(sizeof(float)*m_vVertexData.size()));
-
 		glEnableVertexAttribArray(0);
-		glEnableVertexAttribArray(1);
+
+		// normals only for shaded drawing, the tracking pass reads
+		// positions only
+		if(m_bDrawNormals) {
+			glBufferSubData(GL_ARRAY_BUFFER,
+							sizeof(float)*m_vVertexData.size(),
+							sizeof(float)*m_vNormalData.size(),
+							&m_vNormalData[0]);
+			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0,
+								  (const GLvoid*)(sizeof(float)*m_vVertexData.size()));
+			glEnableVertexAttribArray(1);
+		}
+
+		// the element buffer binding is part of the vertex array
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_idElementBufferObject);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+					 sizeof(GLuint)*m_vIndexData.size(),
+					 &m_vIndexData[0], GL_STATIC_DRAW);
 		
 		glBindVertexArray(0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		// the vertex shader transforms from the particle state
+		if(m_bStateTransforms)
+			return;
 
 		// initialize SSBO for transformation matrices
 		glGenBuffers(1, &m_idSSBOTransforms);
 
 		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_idSSBOTransforms);
-		glBufferData(GL_SHADER_STORAGE_BUFFER, 64*2*(22+16)*16*sizeof(float),
+		glBufferData(GL_SHADER_STORAGE_BUFFER,
+					 m_iMaxViewports*2*(22+16)*16*sizeof(float),
 					 NULL, GL_DYNAMIC_DRAW);
 
 		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
 	}
 	
 	void HandRenderer::DrawSphere(VistaTransformMatrix matModel) {
@@ -388,6 +598,12 @@ namespace rhapsodies {
 		glUseProgram(m_idProgram);
 		glBindVertexArray(m_idVertexArrayObject);
 		glBindBuffer(GL_ARRAY_BUFFER, m_idVertexBufferObject);
+
+		glUniform1i(m_locSplitHandsUniform, m_bSplitHands);
+		glUniform1f(m_locSplitXUniform, m_fSplitX);
+		glUniform1i(m_locSplitLeftHandFirstUniform, m_bSplitLeftHandFirst);
+		if(m_bSplitHands)
+			glEnable(GL_CLIP_DISTANCE0);
 	}
 	
 	void HandRenderer::PerformDraw(
@@ -432,7 +648,8 @@ namespace rhapsodies {
 							&m_vSphereTransforms[0]);
 			glBufferSubData(GL_SHADER_STORAGE_BUFFER,
 							sizeof(VistaTransformMatrix) *
-							iSpheresPerViewport * 64, sizeCylinderTransforms,
+							iSpheresPerViewport * m_iMaxViewports,
+							sizeCylinderTransforms,
 							&m_vCylinderTransforms[0]);
 			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2,
 							 m_idSSBOTransforms);
@@ -449,15 +666,26 @@ namespace rhapsodies {
 		glUniform1i(m_locInstancesPerViewportUniform,
 					iSpheresPerViewportUniform);
 		
+		// cylinder instances follow the sphere instances
+		glUniform1ui(m_locCylinderBaseUniform,
+					 iSpheresPerViewport * m_iMaxViewports);
+
 		// draw all shperes
-		glDrawArraysInstanced(GL_TRIANGLES,
-							  0, m_szSphereData,
-							  iSpheresPerViewport * iViewPortCount);
+		glUniform1i(m_locCylinderUniform, GL_FALSE);
+		if(m_bImpostors) {
+			glDrawArraysInstanced(GL_POINTS, 0, 1,
+								  iSpheresPerViewport * iViewPortCount);
+		}
+		else {
+			glDrawElementsInstanced(GL_TRIANGLES,
+									m_szSphereData, GL_UNSIGNED_INT, 0,
+									iSpheresPerViewport * iViewPortCount);
+		}
 
 
 		// set uniform for transform buffer offset
 		glUniform1ui(m_locTransformOffset,
-					 iSpheresPerViewport * 64 +
+					 iSpheresPerViewport * m_iMaxViewports +
 					 iCylindersPerViewport*iBaseViewport);
 
 		// set uniform for viewport indexing
@@ -466,9 +694,17 @@ namespace rhapsodies {
 
 
 		// draw all cylinders
-		glDrawArraysInstanced(GL_TRIANGLES,
-							  m_szSphereData, m_szCylinderData,
-							  iCylindersPerViewport * iViewPortCount);
+		glUniform1i(m_locCylinderUniform, GL_TRUE);
+		if(m_bImpostors) {
+			glDrawArraysInstanced(GL_POINTS, 0, 1,
+								  iCylindersPerViewport * iViewPortCount);
+		}
+		else {
+			glDrawElementsInstancedBaseVertex(
+				GL_TRIANGLES, m_szCylinderData, GL_UNSIGNED_INT,
+				(const GLvoid*)(sizeof(GLuint)*m_szSphereData),
+				iCylindersPerViewport * iViewPortCount, m_iSphereVertices);
+		}
 
 		if(bTransformTransfer) {
 			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, 0);
@@ -476,12 +712,22 @@ namespace rhapsodies {
 	}
 
 	void HandRenderer::PostDraw() {
+		if(m_bSplitHands)
+			glDisable(GL_CLIP_DISTANCE0);
+
 		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 		glBindVertexArray(0);
 		glUseProgram(0);
 	}
 
+	void HandRenderer::SetHandSplit(bool bSplit, float fSplitX,
+									bool bLeftHandFirst) {
+		m_bSplitHands = bSplit;
+		m_fSplitX = fSplitX;
+		m_bSplitLeftHandFirst = bLeftHandFirst;
+	}
+
 	GLuint HandRenderer::GetSSBOTransformsId() {
 		return m_idSSBOTransforms;
 	}
@@ -15,9 +15,22 @@ namespace rhapsodies {
 	
 	class HandRenderer {
 	public:
+		/**
+		 * With bImpostors each primitive is drawn as one point that
+		 * idProgram expands to a ray cast quad, see impostor.geom.
+		 * Otherwise the tessellated meshes of iSegments are drawn.
+		 *
+		 * With bStateTransforms idProgram computes the instance
+		 * transforms from the particle state (see
+		 * state_transform.part), there is no transform buffer and
+		 * only PerformDraw() without transfer is valid.
+		 */
 		HandRenderer(GLint idProgram,
 					 bool bDrawNormals = false,
-					 int iSegments = 4);
+					 int iSegments = 4,
+					 unsigned int iMaxViewports = 64,
+					 bool bImpostors = false,
+					 bool bStateTransforms = false);
 
 		void DrawHand(HandModel *pModel,
 					  HandGeometry *pModelGeometry);
@@ -29,6 +42,16 @@ namespace rhapsodies {
 						 float *pViewPortData);
 		void PostDraw();
 
+		/**
+		 * Clips each hand to its side of the viewports for the
+		 * draws between PreDraw() and PostDraw(), see
+		 * split_hands.part. fSplitX is the first column of the right
+		 * side in normalized device x, bLeftHandFirst tells whether
+		 * the left hand is drawn on the left side.
+		 */
+		void SetHandSplit(bool bSplit, float fSplitX = 0.0f,
+						  bool bLeftHandFirst = true);
+
 		GLuint GetSSBOTransformsId();
 		
 	private:
@@ -51,22 +74,39 @@ namespace rhapsodies {
 		GLint m_idProgram;
 		GLint m_idTransformBlock;
 		bool m_bDrawNormals;
+		bool m_bImpostors;
+		bool m_bStateTransforms;
+		unsigned int m_iMaxViewports;
+
+		bool m_bSplitHands;
+		float m_fSplitX;
+		bool m_bSplitLeftHandFirst;
 		
+		// index counts, the cylinder indices follow the sphere
+		// indices and are relative to m_iSphereVertices
 		size_t m_szSphereData;
 		size_t m_szCylinderData;
+		size_t m_iSphereVertices;
 		
 		std::vector<float> m_vVertexData;
-		std::vector<float> m_vNormalData;
+		std::vector<float> m_vNormalData; // only with m_bDrawNormals
+		std::vector<GLuint> m_vIndexData;
 		std::vector<VistaTransformMatrix> m_vSphereTransforms;
 		std::vector<VistaTransformMatrix> m_vCylinderTransforms;
 
 		GLuint m_idVertexArrayObject;
 		GLuint m_idVertexBufferObject;
+		GLuint m_idElementBufferObject;
 
 		GLuint m_idSSBOTransforms;
 
 		GLint m_locInstancesPerViewportUniform;
 		GLint m_locTransformOffset;
+		GLint m_locCylinderUniform;
+		GLint m_locCylinderBaseUniform;
+		GLint m_locSplitHandsUniform;
+		GLint m_locSplitXUniform;
+		GLint m_locSplitLeftHandFirstUniform;
 	};
 }
 
@@ -0,0 +1,27 @@
+#include <sstream>
+
+#include "HandStateLayout.hpp"
+
+namespace rhapsodies {
+	namespace HandStateLayout {
+		std::string GenerateGlslHeader() {
+			std::ostringstream oss;
+
+			oss << "#define STATE_JOINT_OFFSET "       << iJointOffset       << "\n"
+				<< "#define STATE_JOINT_COUNT "        << iJointCount        << "\n"
+				<< "#define STATE_POSITION_OFFSET "    << iPositionOffset    << "\n"
+				<< "#define STATE_POSITION_SIZE "      << iPositionSize      << "\n"
+				<< "#define STATE_ORIENTATION_OFFSET " << iOrientationOffset << "\n"
+				<< "#define STATE_ORIENTATION_SIZE "   << iOrientationSize   << "\n"
+				<< "#define STATE_PADDING_OFFSET "     << iPaddingOffset     << "\n"
+				<< "#define STATE_PENALTY_OFFSET "     << iPenaltyOffset     << "\n"
+				<< "#define STATE_HAND_STRIDE "        << iHandStride        << "\n"
+				<< "#define STATE_HAND_COUNT "         << iHandCount         << "\n"
+				<< "#define STATE_PARTICLE_STRIDE "    << iParticleStride    << "\n"
+				<< "#define STATE_HAND_DOF_COUNT "     << iHandDofCount      << "\n"
+				<< "#define STATE_DOF_COUNT "          << iDofCount          << "\n";
+
+			return oss.str();
+		}
+	}
+}
@@ -0,0 +1,62 @@
+#ifndef _RHAPSODIES_HANDSTATELAYOUT
+#define _RHAPSODIES_HANDSTATELAYOUT
+
+#include <cstddef>
+#include <string>
+
+namespace rhapsodies {
+	/**
+	 * Layout of the flat particle state shared by the CPU swarm and
+	 * all shaders operating on the hand model SSBOs. Each hand
+	 * occupies one block of iHandStride floats:
+	 *
+	 * [joint angles | position xyzw | orientation quat | padding | penalty]
+	 *
+	 * A particle holds iHandCount hand blocks, the penalty is only
+	 * used in the first one. The same values are handed to the
+	 * shaders as STATE_* defines, see GenerateGlslHeader().
+	 */
+	namespace HandStateLayout {
+		constexpr size_t iJointOffset       = 0;
+		constexpr size_t iJointCount        = 20;
+
+		constexpr size_t iPositionOffset    = iJointOffset + iJointCount;
+		constexpr size_t iPositionSize      = 4;
+
+		constexpr size_t iOrientationOffset = iPositionOffset + iPositionSize;
+		constexpr size_t iOrientationSize   = 4;
+
+		constexpr size_t iPaddingOffset     =
+			iOrientationOffset + iOrientationSize;
+
+		constexpr size_t iHandStride        = 32;
+		constexpr size_t iPenaltyOffset     = iHandStride - 1;
+
+		constexpr size_t iHandCount         = 2;
+		constexpr size_t iLeftHandOffset    = 0;
+		constexpr size_t iRightHandOffset   = iHandStride;
+
+		constexpr size_t iParticleStride    = iHandCount * iHandStride;
+
+		// searched degrees of freedom: joint angles, position xyz and
+		// the orientation quaternion. position w only pads the vec4.
+		constexpr size_t iHandDofCount      =
+			iJointCount + iPositionSize - 1 + iOrientationSize;
+		constexpr size_t iDofCount          = iHandCount * iHandDofCount;
+
+		static_assert(iPaddingOffset <= iPenaltyOffset,
+					  "hand state does not fit into its stride");
+		static_assert(iPositionSize == 4 && iOrientationSize == 4,
+					  "position and orientation are stored as vec4");
+		static_assert(iParticleStride % 4 == 0,
+					  "particle stride has to keep std430 vec4 alignment");
+
+		/**
+		 * Returns the layout as GLSL #define lines, to be inserted
+		 * after the #version directive of each shader.
+		 */
+		std::string GenerateGlslHeader();
+	}
+}
+
+#endif // _RHAPSODIES_HANDSTATELAYOUT
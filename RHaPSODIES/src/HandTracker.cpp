@@ -28,6 +28,8 @@
 #include <limits>
 #include <exception>
 #include <algorithm>
+#include <iomanip>
+#include <sstream>
 
 #include <GL/glew.h>
 
@@ -45,12 +47,18 @@
 #include "ShaderRegistry.hpp"
 
 #include "HandModel.hpp"
+#include "HandStateLayout.hpp"
 #include "HandGeometry.hpp"
 #include "HandRenderer.hpp"
 #include "DebugView.hpp"
+#include "GpuProfiler.hpp"
+#include "TransferRing.hpp"
 
 #include "PSO/Particle.hpp"
 #include "PSO/ParticleSwarm.hpp"
+#include "PSO/OptimizerParticleSwarm.hpp"
+#include "PSO/OptimizerCMAES.hpp"
+#include "PSO/LevenbergMarquardt.hpp"
 
 #include "CameraFrameRecorder.hpp"
 #include "CameraFramePlayer.hpp"
@@ -191,6 +199,94 @@ namespace {
 		vstr::debug() << std::endl;		
 	}
 
+	// wall clock time of the initialization stages. gl calls may
+	// return before the gpu is done, Finish() waits for it.
+	class StartupProfile {
+	public:
+		StartupProfile() :
+			m_oTimer(VistaTimeUtils::GetStandardTimer()),
+			m_tStart(m_oTimer.GetMicroTime()),
+			m_tLast(m_tStart) {
+		}
+
+		void Mark(const std::string &sStage) {
+			VistaType::microtime tNow = m_oTimer.GetMicroTime();
+			m_vecStages.push_back(std::make_pair(sStage, tNow - m_tLast));
+			m_tLast = tNow;
+		}
+
+		void Finish() {
+			glFinish();
+			Mark("GPU idle");
+		}
+
+		void Print(std::ostream &out) const {
+			// formatted separately, the flags would stick to out
+			std::ostringstream ostr;
+			ostr << std::fixed << std::setprecision(2)
+				 << "Startup profile:" << std::endl;
+			for(size_t i = 0; i < m_vecStages.size(); ++i) {
+				ostr << std::setw(20) << m_vecStages[i].first << ": "
+					 << 1e3*m_vecStages[i].second << " ms" << std::endl;
+			}
+			ostr << std::setw(20) << "Total" << ": "
+				 << 1e3*(m_tLast - m_tStart) << " ms" << std::endl;
+			out << ostr.str() << std::endl;
+		}
+
+	private:
+		const VistaTimer &m_oTimer;
+		VistaType::microtime m_tStart;
+		VistaType::microtime m_tLast;
+		std::vector<std::pair<std::string, VistaType::microtime> > m_vecStages;
+	};
+
+	// offset of a pyramid level in the camera depth pyramid buffer,
+	// levels are stored consecutively starting with 320x240
+	size_t PyramidLevelOffset(unsigned int iLevel) {
+		size_t szOffset = 0;
+		for(unsigned int level = 0; level < iLevel; ++level) {
+			szOffset += (320 >> level) * (240 >> level);
+		}
+		return szOffset;
+	}
+
+	// foreground test of reduce_depth_maps.comp, the filtered depth
+	// is read as signed normalized value with background at 1.0
+	bool IsCameraForeground(unsigned short iDepth) {
+		return short(iDepth) < 0x7fff;
+	}
+
+	// glsl literal of a compile time constant, floats always carry a
+	// decimal point so they are not taken as integers
+	std::string ShaderFloat(float fValue) {
+		std::ostringstream ostr;
+		ostr << std::showpoint << fValue;
+		return ostr.str();
+	}
+
+	std::string ShaderUint(unsigned int iValue) {
+		std::ostringstream ostr;
+		ostr << iValue << "u";
+		return ostr.str();
+	}
+
+	// render program of the swarm pass. layered meshes need no
+	// geometry shader, so they are separate programs.
+	std::string SwarmProgram(bool bImpostors, bool bStateTransforms,
+							 bool bLayered) {
+		if(bImpostors)
+			return bStateTransforms ? "impostor_statetransform" : "impostor";
+
+		std::string sProgram =
+			bStateTransforms ? "statetransform" : "indexedtransform";
+		return bLayered ? sProgram + "_layered" : sProgram;
+	}
+
+	bool IsPowerOfTwo(unsigned int iValue) {
+		return iValue != 0 && (iValue & (iValue - 1)) == 0;
+	}
+
 	VistaPropertyList ReadConfigSubList(
 		VistaPropertyList oConfig,
 		std::string sSectionName) {
@@ -209,10 +305,41 @@ namespace rhapsodies {
 	const std::string sErosionSizeName  = "EROSION_SIZE";
 	const std::string sDilationSizeName = "DILATION_SIZE";
 
+	const std::string sSwarmSizeName         = "SWARM_SIZE";
 	const std::string sPSOGenerationsName    = "PSO_GENERATIONS";
 	const std::string sPhiCognitiveBeginName = "PHI_COGNITIVE_BEGIN";
 	const std::string sPhiCognitiveEndName   = "PHI_COGNITIVE_END";
 	const std::string sKeepKBestName         = "KEEP_KBEST";
+	const std::string sGpuSwarmInitName      = "GPU_SWARM_INIT";
+	const std::string sResolutionScheduleName = "RESOLUTION_SCHEDULE";
+	const std::string sConvergencePlateauName = "CONVERGENCE_PLATEAU";
+	const std::string sConvergenceEpsilonName = "CONVERGENCE_EPSILON";
+	const std::string sConvergenceSpreadName  = "CONVERGENCE_SPREAD";
+	const std::string sDecoupleHandsName      = "DECOUPLE_HANDS";
+	const std::string sDecoupleMinGapName     = "DECOUPLE_MIN_GAP";
+	const std::string sMotionDampingName      = "MOTION_DAMPING";
+	const std::string sMotionSpreadName       = "MOTION_SPREAD";
+	const std::string sRandomSeedName         = "RANDOM_SEED";
+	const std::string sSpreadSequenceName     = "SPREAD_SEQUENCE";
+	const std::string sOptimizerName          = "OPTIMIZER";
+	const std::string sTopologyName           = "PSO_TOPOLOGY";
+	const std::string sFusedStepName          = "PSO_FUSED_STEP";
+	const std::string sInertiaBeginName       = "INERTIA_BEGIN";
+	const std::string sInertiaEndName         = "INERTIA_END";
+	const std::string sCMAESSigmaName         = "CMAES_SIGMA";
+	const std::string sRefineStepsName        = "REFINE_STEPS";
+	const std::string sRefineDifferenceStepName = "REFINE_DIFFERENCE_STEP";
+	const std::string sRefineDampingName      = "REFINE_DAMPING";
+	const std::string sDepthMarginName        = "DEPTH_MARGIN";
+	const std::string sLambdaName             = "PENALTY_LAMBDA";
+	const std::string sLambdaKName            = "PENALTY_LAMBDA_K";
+
+	const std::string sOptimizerPSO   = "PSO";
+	const std::string sOptimizerCMAES = "CMAES";
+	const std::string sTopologyGlobal = "GLOBAL";
+	const std::string sTopologyRing   = "RING";
+	const std::string sSequenceRandom = "RANDOM";
+	const std::string sSequenceHalton = "HALTON";
 
 	const std::string sRecordingName  = "RECORDING";
 	const std::string sPlaybackName   = "PLAYBACK";
@@ -230,17 +357,91 @@ namespace rhapsodies {
 	const std::string sSmoothingFactorName = "SMOOTHING_FACTOR";
 	
 	const std::string sViewportBatchName = "VIEWPORT_BATCH";
+	const std::string sPrimitivesName    = "PRIMITIVES";
+	const std::string sTransformsName    = "TRANSFORMS";
+	const std::string sTargetName        = "TARGET";
+
+	const std::string sPrimitivesMesh     = "MESH";
+	const std::string sPrimitivesImpostor = "IMPOSTOR";
+	const std::string sTransformsBuffer   = "BUFFER";
+	const std::string sTransformsState    = "STATE";
+	const std::string sTargetAtlas        = "ATLAS";
+	const std::string sTargetLayered      = "LAYERED";
+
+	// joint angle limits in degrees, read as "min, max" and compiled
+	// into joint_bounds.part as <define>_MIN and <define>_MAX
+	struct JointLimit {
+		const char *sName;
+		const char *sDefine;
+		float fMin;
+		float fMax;
+	};
+
+	const JointLimit aJointLimits[] = {
+		{ "THUMB_FLEXION_BASE_LIMITS", "THUMB_FLEXION_BASE", -60.0f, 40.0f },
+		{ "THUMB_ADDUCTION_LIMITS",    "THUMB_ADDUCTION",     10.0f, 90.0f },
+		{ "THUMB_FLEXION_TIP_LIMITS",  "THUMB_FLEXION_TIP",    0.0f, 90.0f },
+		{ "FINGER_ADDUCTION_LIMITS",   "FINGER_ADDUCTION",   -30.0f, 30.0f },
+		{ "FINGER_FLEXION_LIMITS",     "FINGER_FLEXION",       0.0f, 90.0f }
+	};
+	const size_t iJointLimitCount = sizeof(aJointLimits)/sizeof(JointLimit);
+
+	// depth range of the tracker projection, see SetupProjection()
+	const float fZNear = 0.1f;
+	const float fZFar  = 1.1f;
 
 	const int iSSBOHandModelsLocation         = 0;
 	const int iSSBOHandGeometryLocation       = 1;
 	const int iSSBOTransformsLocation         = 2;
+	const int iSSBOConvergenceLocation        = 3;
 	const int iSSBOHandModelsIBestLocation    = 4;
 	const int iSSBOHandModelsGBestLocation    = 5;
 	const int iSSBOHandModelsVelocityLocation = 6;
-	const int iSSBORandomLocation             = 7;
 	const int iSSBODebugLocation              = 8;
+	const int iSSBOMotionLocation             = 9;
+	const int iSSBOReductionLocation          = 11;
+	const int iSSBOCameraLocation             = 12;
 
 	const std::string sEvalOutputSuffix = ".out";
+	const std::string sBenchOutputSuffix = ".bench";
+
+	const unsigned int iSwarmSizeMin     = 16;
+	const unsigned int iSwarmSizeMax     = 256;
+	const unsigned int iSwarmSizeDefault = 64;
+
+	// coarsest depth pyramid level, 80x60
+	const int iResolutionLevelMax = 2;
+
+	// frames and generations covered by the GPU profile summaries
+	const size_t iGpuProfileHistory = 300;
+
+	// local work group size of update_scores.comp
+	const unsigned int iScoresGroupSize = 4;
+
+	// pixels per work group of reduce_depth_maps.comp
+	const unsigned int iReductionGroupWidth  = 8;
+	const unsigned int iReductionGroupHeight = 16;
+
+	// uints per particle in the reduction SSBO: difference, union
+	// and intersection for five column strips and two sides plus
+	// padding, see reduce_depth_maps.comp
+	const size_t iReductionResultSize = 24;
+
+	// entries per resolution level in the camera SSBO: the number of
+	// camera foreground pixels left of each column of a tile
+	const size_t iCameraColumnEntries = 320 + 1;
+
+	// header of the convergence SSBO, followed by one spread value
+	// per particle, see update_gbest.comp
+	const size_t iConvergenceHeaderSize = 4;
+	const size_t iConvergenceFlagOffset = 3;
+
+	// radius around the hand position covering the whole hand in m,
+	// used for screen space bounding boxes
+	const float fHandBoundingRadius = 0.12f;
+
+	// floats per particle in all hand model SSBOs
+	const size_t iStateSize = rhapsodies::HandStateLayout::iParticleStride;
 
 /*============================================================================*/
 /* CONSTRUCTORS / DESTRUCTOR                                                  */
@@ -254,8 +455,23 @@ namespace rhapsodies {
 		m_pShaderReg(NULL),
 		m_pHandGeometry(NULL),
 		m_pHandRenderer(NULL),
-		m_vViewportData(4*64),
+		m_pSwarmRenderer(NULL),
+		m_iTilesX(0),
+		m_iTilesY(0),
+		m_iResolutionLevels(1),
 		m_pDebugView(NULL),
+		m_idRenderedTexture(0),
+		m_idRenderedTextureFBO(0),
+		m_idRenderedTextureView(0),
+		m_idDifferenceTexture(0),
+		m_bInspectDifference(false),
+		m_pCameraUpload(NULL),
+		m_pSwarmUpload(NULL),
+		m_pSwarmReadback(NULL),
+		m_pStartPoseReadback(NULL),
+		m_pGBestReadback(NULL),
+		m_pConvergenceReadback(NULL),
+		m_pEvaluationReadback(NULL),
 		m_bFrameRecording(false),
 		m_bFramePlayback(false),
 		m_pFrameRecorder(NULL),
@@ -263,10 +479,18 @@ namespace rhapsodies {
 		m_pFrameFilter(NULL),
 		m_iEvalIteration(0),
 		m_bTrackingEnabled(false),
+		m_bSwarmUploadPending(true),
+		m_bDecoupledHands(false),
+		m_bLeftHandFirst(false),
+		m_iSplitPixel(160),
 		m_pSwarm(NULL),
+		m_pOptimizer(NULL),
+		m_pRefinement(NULL),
+		m_pGpuProfiler(NULL),
 		m_pHandModelLeft(NULL),
 		m_pHandModelRight(NULL),
 		m_pRNG(NULL),
+		m_iRandomFrame(0),
 		m_pProfiler(new VistaBasicProfiler) {
 
 		m_pShaderReg = RHaPSODIES::GetShaderRegistry();
@@ -277,9 +501,6 @@ namespace rhapsodies {
 			e *= 0.9;
 		}
 		
-		m_pHandRenderer =
-			new HandRenderer(m_pShaderReg->GetProgram("indexedtransform"));
-
 		m_pFrameRecorder = new CameraFrameRecorder;
 		m_pFramePlayer   = new CameraFramePlayer;
 
@@ -288,45 +509,21 @@ namespace rhapsodies {
 		m_pUVMapBuffer     = new float[320*240*2];
 
 		m_pRNG = VistaRandomNumberGenerator::GetStandardRNG();
-
-		m_idGenerateTransformsProgram =
-			m_pShaderReg->GetProgram("generate_transforms");
-
-		m_idPrepareReductionTexturesProgram =
-			m_pShaderReg->GetProgram("prepare_reduction_textures");
-
-		m_idReduction0DifferenceProgram = m_pShaderReg->GetProgram("reduction0_difference");
-		m_idReduction1DifferenceProgram = m_pShaderReg->GetProgram("reduction1_difference");
-		m_idReduction2DifferenceProgram = m_pShaderReg->GetProgram("reduction2_difference");
-		m_idReduction0UnionProgram = m_pShaderReg->GetProgram("reduction0_union");
-		m_idReduction1UnionProgram = m_pShaderReg->GetProgram("reduction1_union");
-		m_idReduction2UnionProgram = m_pShaderReg->GetProgram("reduction2_union");
-		m_idReduction0IntersectionProgram = m_pShaderReg->GetProgram("reduction0_intersection");
-		m_idReduction1IntersectionProgram = m_pShaderReg->GetProgram("reduction1_intersection");
-		m_idReduction2IntersectionProgram = m_pShaderReg->GetProgram("reduction2_intersection");
-
-		m_idUpdateScoresProgram = m_pShaderReg->GetProgram("update_scores");
-		m_idUpdateGBestProgram  = m_pShaderReg->GetProgram("update_gbest");
-		m_idUpdateSwarmProgram  = m_pShaderReg->GetProgram("update_swarm");
-
-		m_idColorFragProgram =
-			m_pShaderReg->GetProgram("shaded_indexedtransform");
-		m_locColorUniform =
-			glGetUniformLocation(m_idColorFragProgram, "color_in");
-
-		glUseProgram(m_idColorFragProgram);
-		glUniform3f(m_locColorUniform, 1.0f, 0.0f, 0.0f);
-
-		m_locRandomOffsetUniform =
-			glGetUniformLocation(m_idUpdateSwarmProgram, "iRandomOffset");
-		m_locPhiCognitiveUniform =
-			glGetUniformLocation(m_idUpdateSwarmProgram, "fPhiCognitive");
-		m_locPhiSocialUniform =
-			glGetUniformLocation(m_idUpdateSwarmProgram, "fPhiSocial");
 	}
 
 	HandTracker::~HandTracker() {
 		delete m_pSwarm;
+		delete m_pOptimizer;
+		delete m_pRefinement;
+		delete m_pGpuProfiler;
+
+		delete m_pCameraUpload;
+		delete m_pSwarmUpload;
+		delete m_pSwarmReadback;
+		delete m_pStartPoseReadback;
+		delete m_pGBestReadback;
+		delete m_pConvergenceReadback;
+		delete m_pEvaluationReadback;
 		
 		delete [] m_pColorBuffer;
 		delete [] m_pDepthBuffer;
@@ -336,6 +533,8 @@ namespace rhapsodies {
 		delete m_pFramePlayer;
 		delete m_pFrameRecorder;
 		
+		if(m_pSwarmRenderer != m_pHandRenderer)
+			delete m_pSwarmRenderer;
 		delete m_pHandRenderer;
 		delete m_pHandGeometry;
 
@@ -364,9 +563,15 @@ namespace rhapsodies {
 	}
 
 	GLuint HandTracker::GetRenderedTextureId() {
+		if(m_oConfig.bLayered)
+			return m_idRenderedTextureView;
 		return m_idRenderedTexture;
 	}
 
+	GLenum HandTracker::GetRenderedTextureTarget() {
+		return m_oConfig.bLayered ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+	}
+
 	GLuint HandTracker::GetCameraTextureId() {
 		return m_idCameraTexture;
 	}
@@ -375,6 +580,20 @@ namespace rhapsodies {
 		return m_idDifferenceTexture;
 	}
 
+	void HandTracker::SetInspectDifference(bool bInspect) {
+		// the texture is kept once created, inspection may be
+		// switched on again
+		if(bInspect && m_idDifferenceTexture == 0 &&
+		   HasGLComputeCapabilities())
+			InitDifferenceTexture();
+
+		m_bInspectDifference = bInspect;
+	}
+
+	bool HandTracker::GetInspectDifference() {
+		return m_bInspectDifference;
+	}
+
 	void HandTracker::ReadConfig() {
 		VistaIniFileParser oIniParser(true);
 		oIniParser.ReadFile(RHaPSODIES::sRDIniFile);
@@ -412,6 +631,24 @@ namespace rhapsodies {
 
 		const VistaPropertyList oParticleSwarmConfig =
 			ReadConfigSubList(oConfig, RHaPSODIES::sParticleSwarmSectionName);
+		m_oConfig.iSwarmSize = oParticleSwarmConfig.GetValueOrDefault(
+			sSwarmSizeName, iSwarmSizeDefault);
+		if(!IsPowerOfTwo(m_oConfig.iSwarmSize) ||
+		   m_oConfig.iSwarmSize < iSwarmSizeMin ||
+		   m_oConfig.iSwarmSize > iSwarmSizeMax) {
+			vstr::warn() << sSwarmSizeName << " must be a power of two in ["
+						 << iSwarmSizeMin << ", " << iSwarmSizeMax
+						 << "], using " << iSwarmSizeDefault << std::endl;
+			m_oConfig.iSwarmSize = iSwarmSizeDefault;
+		}
+
+		// derive a (nearly) square tile atlas, wider than high
+		unsigned int iLog2Size = 0;
+		while((1u << iLog2Size) < m_oConfig.iSwarmSize)
+			iLog2Size++;
+		m_iTilesX = 1u << ((iLog2Size + 1) / 2);
+		m_iTilesY = m_oConfig.iSwarmSize / m_iTilesX;
+
 		m_oConfig.iPSOGenerations = oParticleSwarmConfig.GetValueOrDefault(
 			sPSOGenerationsName, 45);
 		m_oConfig.fPhiCognitiveBegin = oParticleSwarmConfig.GetValueOrDefault(
@@ -420,12 +657,165 @@ namespace rhapsodies {
 			sPhiCognitiveEndName, 2.8);
 		m_oConfig.iKeepKBest = oParticleSwarmConfig.GetValueOrDefault(
 			sKeepKBestName, 0);
+		m_oConfig.bGpuSwarmInit = oParticleSwarmConfig.GetValueOrDefault(
+			sGpuSwarmInitName, true);
+
+		m_oConfig.vecResolutionSchedule = oParticleSwarmConfig.GetValueOrDefault(
+			sResolutionScheduleName, std::vector<int>(1, 0));
+		if(m_oConfig.vecResolutionSchedule.empty())
+			m_oConfig.vecResolutionSchedule.push_back(0);
+
+		m_iResolutionLevels = 1;
+		for(int &iLevel: m_oConfig.vecResolutionSchedule) {
+			if(iLevel < 0 || iLevel > iResolutionLevelMax) {
+				vstr::warn() << sResolutionScheduleName << " levels must be in [0, "
+							 << iResolutionLevelMax << "], clamping "
+							 << iLevel << std::endl;
+				iLevel = std::min(std::max(iLevel, 0), iResolutionLevelMax);
+			}
+			m_iResolutionLevels = std::max(m_iResolutionLevels,
+										   (unsigned int)(iLevel + 1));
+		}
+
+		m_oConfig.iConvergencePlateau = oParticleSwarmConfig.GetValueOrDefault(
+			sConvergencePlateauName, 0);
+		m_oConfig.fConvergenceEpsilon = oParticleSwarmConfig.GetValueOrDefault(
+			sConvergenceEpsilonName, 0.001f);
+		m_oConfig.fConvergenceSpread = oParticleSwarmConfig.GetValueOrDefault(
+			sConvergenceSpreadName, 5.0f);
+
+		m_oConfig.bDecoupleHands = oParticleSwarmConfig.GetValueOrDefault(
+			sDecoupleHandsName, false);
+		m_oConfig.iDecoupleMinGap = oParticleSwarmConfig.GetValueOrDefault(
+			sDecoupleMinGapName, 32);
+
+		m_oConfig.fMotionDamping = oParticleSwarmConfig.GetValueOrDefault(
+			sMotionDampingName, 0.0f);
+		m_oConfig.fMotionSpread = oParticleSwarmConfig.GetValueOrDefault(
+			sMotionSpreadName, 0.0f);
+
+		// without a configured seed every run draws its own
+		m_oConfig.bFixedSeed =
+			oParticleSwarmConfig.HasProperty(sRandomSeedName);
+		m_oConfig.iRandomSeed = oParticleSwarmConfig.GetValueOrDefault(
+			sRandomSeedName, (unsigned int)(m_pRNG->GenerateInt32()));
+
+		std::string sSequence = oParticleSwarmConfig.GetValueOrDefault(
+			sSpreadSequenceName, sSequenceRandom);
+		if(sSequence != sSequenceRandom && sSequence != sSequenceHalton) {
+			vstr::warn() << "Unknown " << sSpreadSequenceName << " "
+						 << sSequence << ", using "
+						 << sSequenceRandom << std::endl;
+		}
+		m_oConfig.bHaltonSpread = (sSequence == sSequenceHalton);
+
+		m_oConfig.sOptimizer = oParticleSwarmConfig.GetValueOrDefault(
+			sOptimizerName, sOptimizerPSO);
+		if(m_oConfig.sOptimizer != sOptimizerPSO &&
+		   m_oConfig.sOptimizer != sOptimizerCMAES) {
+			vstr::warn() << "Unknown " << sOptimizerName << " "
+						 << m_oConfig.sOptimizer << ", using "
+						 << sOptimizerPSO << std::endl;
+			m_oConfig.sOptimizer = sOptimizerPSO;
+		}
+
+		std::string sTopology = oParticleSwarmConfig.GetValueOrDefault(
+			sTopologyName, sTopologyGlobal);
+		if(sTopology != sTopologyGlobal && sTopology != sTopologyRing) {
+			vstr::warn() << "Unknown " << sTopologyName << " "
+						 << sTopology << ", using "
+						 << sTopologyGlobal << std::endl;
+		}
+		m_oConfig.bRingTopology = (sTopology == sTopologyRing);
+
+		m_oConfig.bFusedStep = oParticleSwarmConfig.GetValueOrDefault(
+			sFusedStepName, false);
+
+		m_oConfig.fInertiaBegin = oParticleSwarmConfig.GetValueOrDefault(
+			sInertiaBeginName, 0.72984f);
+		m_oConfig.fInertiaEnd = oParticleSwarmConfig.GetValueOrDefault(
+			sInertiaEndName, 0.72984f);
+		m_oConfig.fCMAESSigma = oParticleSwarmConfig.GetValueOrDefault(
+			sCMAESSigmaName, 0.5f);
+
+		// one tile per degree of freedom plus the current pose
+		m_oConfig.iRefineSteps = oParticleSwarmConfig.GetValueOrDefault(
+			sRefineStepsName, 0);
+		if(m_oConfig.iRefineSteps > 0 &&
+		   m_oConfig.iSwarmSize <= HandStateLayout::iDofCount) {
+			vstr::warn() << sRefineStepsName << " needs a "
+						 << sSwarmSizeName << " above "
+						 << HandStateLayout::iDofCount
+						 << ", refinement disabled" << std::endl;
+			m_oConfig.iRefineSteps = 0;
+		}
+		m_oConfig.fRefineDifferenceStep = oParticleSwarmConfig.GetValueOrDefault(
+			sRefineDifferenceStepName, 0.5f);
+		m_oConfig.fRefineDamping = oParticleSwarmConfig.GetValueOrDefault(
+			sRefineDampingName, 1.0f);
+
+		m_oConfig.fDepthMargin = oParticleSwarmConfig.GetValueOrDefault(
+			sDepthMarginName, 0.04f);
+		if(m_oConfig.fDepthMargin <= 0.0f) {
+			vstr::warn() << sDepthMarginName << " must be positive, using "
+						 << 0.04f << std::endl;
+			m_oConfig.fDepthMargin = 0.04f;
+		}
+		m_oConfig.fLambda = oParticleSwarmConfig.GetValueOrDefault(
+			sLambdaName, 50.0f);
+		m_oConfig.fLambdaK = oParticleSwarmConfig.GetValueOrDefault(
+			sLambdaKName, 2.0f);
+
+		m_oConfig.vecJointLimits.clear();
+		for(size_t i = 0; i < iJointLimitCount; ++i) {
+			const JointLimit &oLimit = aJointLimits[i];
+			std::vector<float> vecDefault;
+			vecDefault.push_back(oLimit.fMin);
+			vecDefault.push_back(oLimit.fMax);
+
+			std::vector<float> vecLimit = oParticleSwarmConfig.GetValueOrDefault(
+				oLimit.sName, vecDefault);
+			if(vecLimit.size() != 2 || vecLimit[0] > vecLimit[1]) {
+				vstr::warn() << oLimit.sName << " must be \"min, max\", using "
+							 << oLimit.fMin << ", " << oLimit.fMax << std::endl;
+				vecLimit = vecDefault;
+			}
+			m_oConfig.vecJointLimits.insert(m_oConfig.vecJointLimits.end(),
+											vecLimit.begin(), vecLimit.end());
+		}
 
 		const VistaPropertyList oRenderingConfig =
 			ReadConfigSubList(oConfig, RHaPSODIES::sRenderingSectionName);
 		m_oConfig.iViewportBatch = oRenderingConfig.GetValueOrDefault(
 			sViewportBatchName, 1);
 
+		std::string sPrimitives = oRenderingConfig.GetValueOrDefault(
+			sPrimitivesName, sPrimitivesMesh);
+		if(sPrimitives != sPrimitivesMesh && sPrimitives != sPrimitivesImpostor) {
+			vstr::warn() << "Unknown " << sPrimitivesName << " "
+						 << sPrimitives << ", using "
+						 << sPrimitivesMesh << std::endl;
+		}
+		m_oConfig.bImpostors = (sPrimitives == sPrimitivesImpostor);
+
+		std::string sTransforms = oRenderingConfig.GetValueOrDefault(
+			sTransformsName, sTransformsBuffer);
+		if(sTransforms != sTransformsBuffer && sTransforms != sTransformsState) {
+			vstr::warn() << "Unknown " << sTransformsName << " "
+						 << sTransforms << ", using "
+						 << sTransformsBuffer << std::endl;
+		}
+		m_oConfig.bStateTransforms = (sTransforms == sTransformsState);
+
+		std::string sTarget = oRenderingConfig.GetValueOrDefault(
+			sTargetName, sTargetAtlas);
+		if(sTarget != sTargetAtlas && sTarget != sTargetLayered) {
+			vstr::warn() << "Unknown " << sTargetName << " "
+						 << sTarget << ", using "
+						 << sTargetAtlas << std::endl;
+		}
+		m_oConfig.bLayered = (sTarget == sTargetLayered);
+
 		const VistaPropertyList oEvaluationConfig =
 			ReadConfigSubList(oConfig, RHaPSODIES::sEvaluationSectionName);
 		m_oConfig.sRecordingFile = oEvaluationConfig.GetValueOrDefault(
@@ -466,17 +856,80 @@ namespace rhapsodies {
 
 		out << "- Rendering:" << std::endl;
 		out << "Viewport batch:   " << m_oConfig.iViewportBatch
-					<< std::endl << std::endl;
+					<< std::endl;
+		out << "Primitives:       "
+			<< (m_oConfig.bImpostors ? sPrimitivesImpostor : sPrimitivesMesh)
+			<< std::endl;
+		out << "Transforms:       "
+			<< (m_oConfig.bStateTransforms ? sTransformsState : sTransformsBuffer)
+			<< std::endl;
+		out << "Target:           "
+			<< (m_oConfig.bLayered ? sTargetLayered : sTargetAtlas)
+			<< std::endl << std::endl;
 		
 		out << "- Particle swarm:" << std::endl;
+		out << "Swarm size:         " << m_oConfig.iSwarmSize
+			<< " (" << m_iTilesX << "x" << m_iTilesY << " tiles)"
+			<< std::endl;
 		out << "PSO Generations:    " << m_oConfig.iPSOGenerations
 					<< std::endl;
+		out << "Optimizer:          " << m_oConfig.sOptimizer << std::endl;
+		if(m_oConfig.sOptimizer == sOptimizerCMAES) {
+			out << "CMA-ES sigma:       " << m_oConfig.fCMAESSigma
+				<< std::endl;
+		}
+		else {
+			out << "Topology:           "
+				<< (m_oConfig.bRingTopology ? sTopologyRing : sTopologyGlobal)
+				<< std::endl;
+			out << "Inertia:            " << m_oConfig.fInertiaBegin
+				<< " - " << m_oConfig.fInertiaEnd << std::endl;
+			out << "Fused step:         " << std::boolalpha
+				<< m_oConfig.bFusedStep << std::endl;
+		}
 		out << "PhiCognitive Begin: " << m_oConfig.fPhiCognitiveBegin
 					<< std::endl;
 		out << "PhiCognitive End:   " << m_oConfig.fPhiCognitiveEnd
 					<< std::endl;
 		out << "Keep k best:        " << m_oConfig.iKeepKBest
-					<< std::endl << std::endl;
+					<< std::endl;
+		out << "GPU swarm init:     " << std::boolalpha
+			<< m_oConfig.bGpuSwarmInit << std::endl;
+		out << "Resolution schedule:";
+		for(int iLevel: m_oConfig.vecResolutionSchedule) {
+			out << " " << (320 >> iLevel) << "x" << (240 >> iLevel);
+		}
+		out << std::endl;
+		out << "Convergence plateau: " << m_oConfig.iConvergencePlateau
+			<< " (epsilon " << m_oConfig.fConvergenceEpsilon
+			<< ", spread " << m_oConfig.fConvergenceSpread << ")"
+			<< std::endl;
+		out << "Decouple hands:     " << std::boolalpha
+			<< m_oConfig.bDecoupleHands << " (min gap "
+			<< m_oConfig.iDecoupleMinGap << "px)"
+			<< std::endl;
+		out << "Motion model:       damping " << m_oConfig.fMotionDamping
+			<< ", spread " << m_oConfig.fMotionSpread
+			<< std::endl;
+		out << "Refinement steps:   " << m_oConfig.iRefineSteps
+			<< " (difference step " << m_oConfig.fRefineDifferenceStep
+			<< ", damping " << m_oConfig.fRefineDamping << ")"
+			<< std::endl;
+		out << "Objective:          depth margin " << m_oConfig.fDepthMargin
+			<< ", lambda " << m_oConfig.fLambda
+			<< ", lambda k " << m_oConfig.fLambdaK
+			<< std::endl;
+		out << "Joint limits:      ";
+		for(size_t i = 0; i < iJointLimitCount; ++i) {
+			out << " [" << m_oConfig.vecJointLimits[2*i]
+				<< ", " << m_oConfig.vecJointLimits[2*i+1] << "]";
+		}
+		out << std::endl;
+		out << "Spread sequence:    "
+			<< (m_oConfig.bHaltonSpread ? sSequenceHalton : sSequenceRandom)
+			<< std::endl;
+		out << "Random seed:        " << m_oConfig.iRandomSeed
+			<< std::endl << std::endl;
 
 		out << "- Evaluation:" << std::endl;
 		out << "Recording file: " << m_oConfig.sRecordingFile
@@ -499,16 +952,27 @@ namespace rhapsodies {
 		vstr::out() << "Initializing RHaPSODIES HandTracker"
 					<< std::endl << std::endl;
 
+		StartupProfile oProfile;
+
 		ReadConfig();
 		PrintConfig(vstr::out());
+		oProfile.Mark("Config");
+
+		InitPrograms();
+		oProfile.Mark("Shaders");
 
 		InitFrameFilter();
+		oProfile.Mark("Frame filter");
 		InitRendering();
+		m_pGpuProfiler = new GpuProfiler(iGpuProfileHistory);
+		oProfile.Mark("Rendering");
 
 		if(HasGLComputeCapabilities()) {
 			PrintGpuLimits();
 			InitGpuPSO();
+			oProfile.Mark("GPU PSO");
 			InitReduction();
+			oProfile.Mark("Reduction");
 		}
 		else {
 			vstr::debug()
@@ -518,9 +982,15 @@ namespace rhapsodies {
 
 		InitParticleSwarm();
 		InitOutputModel();
+		oProfile.Mark("Particle swarm");
 
-		if(m_oConfig.bEvaluate)
+		if(m_oConfig.bEvaluate) {
 			InitEvaluation();
+			oProfile.Mark("Evaluation");
+		}
+
+		oProfile.Finish();
+		oProfile.Print(vstr::out());
 		
 		return true;
 	}
@@ -529,6 +999,176 @@ namespace rhapsodies {
 		return GLEW_ARB_shader_image_load_store && GLEW_ARB_compute_shader;
 	}
 
+	bool HandTracker::InitPrograms() {
+		// gl_Layer from the vertex shader
+		if(m_oConfig.bLayered && !GLEW_ARB_shader_viewport_layer_array &&
+		   !GLEW_AMD_vertex_shader_layer) {
+			vstr::warn() << "ARB_shader_viewport_layer_array not supported, "
+						 << "rendering to the " << sTargetAtlas
+						 << " instead." << std::endl;
+			m_oConfig.bLayered = false;
+		}
+
+		m_mapShaderDefines.clear();
+		m_mapShaderDefines["SWARM_SIZE"] = ShaderUint(m_oConfig.iSwarmSize);
+		m_mapShaderDefines["TILES_X"] = ShaderUint(m_iTilesX);
+		m_mapShaderDefines["TILES_Y"] = ShaderUint(m_iTilesY);
+		m_mapShaderDefines["DEPTH_MARGIN"] = ShaderFloat(m_oConfig.fDepthMargin);
+		m_mapShaderDefines["Z_NEAR"] = ShaderFloat(fZNear);
+		m_mapShaderDefines["Z_FAR"]  = ShaderFloat(fZFar);
+		m_mapShaderDefines["PENALTY_LAMBDA"] = ShaderFloat(m_oConfig.fLambda);
+		m_mapShaderDefines["PENALTY_LAMBDA_K"] =
+			ShaderFloat(m_oConfig.fLambdaK);
+		for(size_t i = 0; i < iJointLimitCount; ++i) {
+			std::string sDefine = aJointLimits[i].sDefine;
+			m_mapShaderDefines[sDefine + "_MIN"] =
+				ShaderFloat(m_oConfig.vecJointLimits[2*i]);
+			m_mapShaderDefines[sDefine + "_MAX"] =
+				ShaderFloat(m_oConfig.vecJointLimits[2*i+1]);
+		}
+		if(m_oConfig.bLayered)
+			m_mapShaderDefines["LAYERED"] = "1";
+
+		// submit every variant before the first query, so the
+		// driver can compile them in parallel. InitGpuPSO() picks up
+		// the optimizer programs.
+		const char *aPrograms[] = {
+			"generate_transforms", "reduce_depth_maps", "update_scores",
+			"update_gbest", "initialize_swarm"
+		};
+		for(const char *sProgram: aPrograms)
+			GetSpecializedProgram(sProgram);
+
+		if(m_oConfig.sOptimizer == sOptimizerCMAES) {
+			GetSpecializedProgram("cmaes_update");
+			GetSpecializedProgram("cmaes_sample");
+		}
+		else if(m_oConfig.bFusedStep) {
+			GetSpecializedProgram("pso_step");
+		}
+		else {
+			GetSpecializedProgram("update_swarm");
+		}
+		if(m_oConfig.iRefineSteps > 0) {
+			GetSpecializedProgram("refine_jacobian");
+			GetSpecializedProgram("refine_solve");
+			GetSpecializedProgram("refine_accept");
+		}
+		if(m_oConfig.bImpostors)
+			m_pShaderReg->GetProgram("impostor");
+		GetSwarmProgram();
+
+		m_pShaderReg->WaitForPrograms();
+		vstr::out() << "Shader programs: "
+					<< m_pShaderReg->GetCachedProgramCount() << " of "
+					<< m_pShaderReg->GetProgramCount()
+					<< " from cache" << std::endl << std::endl;
+
+		m_idGenerateTransformsProgram =
+			GetSpecializedProgram("generate_transforms");
+
+		m_idReduceDepthMapsProgram =
+			GetSpecializedProgram("reduce_depth_maps");
+		m_locReductionLevelUniform =
+			glGetUniformLocation(m_idReduceDepthMapsProgram, "iLevel");
+		m_locSplitPixelUniform =
+			glGetUniformLocation(m_idReduceDepthMapsProgram, "iSplitPixel");
+		m_locInspectDifferenceUniform =
+			glGetUniformLocation(m_idReduceDepthMapsProgram,
+								 "bInspectDifference");
+
+		m_idUpdateScoresProgram = GetSpecializedProgram("update_scores");
+		m_locResetIBestUniform =
+			glGetUniformLocation(m_idUpdateScoresProgram, "bResetIBest");
+		m_locScoresDecoupledUniform =
+			glGetUniformLocation(m_idUpdateScoresProgram, "bDecoupled");
+		m_locLeftHandFirstUniform =
+			glGetUniformLocation(m_idUpdateScoresProgram, "bLeftHandFirst");
+		m_locEvaluateOnlyUniform =
+			glGetUniformLocation(m_idUpdateScoresProgram, "bEvaluateOnly");
+		m_idUpdateGBestProgram  = GetSpecializedProgram("update_gbest");
+		m_locResetConvergenceUniform =
+			glGetUniformLocation(m_idUpdateGBestProgram, "bResetConvergence");
+		m_locConvergenceEpsilonUniform =
+			glGetUniformLocation(m_idUpdateGBestProgram, "fConvergenceEpsilon");
+		m_locConvergenceSpreadUniform =
+			glGetUniformLocation(m_idUpdateGBestProgram, "fConvergenceSpread");
+		m_locConvergencePlateauUniform =
+			glGetUniformLocation(m_idUpdateGBestProgram, "iConvergencePlateau");
+		m_locGBestDecoupledUniform =
+			glGetUniformLocation(m_idUpdateGBestProgram, "bDecoupled");
+		m_idInitializeSwarmProgram =
+			GetSpecializedProgram("initialize_swarm");
+
+		m_idPSOStepProgram = 0;
+		if(m_oConfig.sOptimizer == sOptimizerPSO && m_oConfig.bFusedStep) {
+			m_idPSOStepProgram = GetSpecializedProgram("pso_step");
+			m_locStepResetIBestUniform =
+				glGetUniformLocation(m_idPSOStepProgram, "bResetIBest");
+			m_locStepDecoupledUniform =
+				glGetUniformLocation(m_idPSOStepProgram, "bDecoupled");
+			m_locStepLeftHandFirstUniform =
+				glGetUniformLocation(m_idPSOStepProgram, "bLeftHandFirst");
+			m_locStepResetConvergenceUniform =
+				glGetUniformLocation(m_idPSOStepProgram, "bResetConvergence");
+			m_locStepConvergenceEpsilonUniform =
+				glGetUniformLocation(m_idPSOStepProgram, "fConvergenceEpsilon");
+			m_locStepConvergenceSpreadUniform =
+				glGetUniformLocation(m_idPSOStepProgram, "fConvergenceSpread");
+			m_locStepConvergencePlateauUniform =
+				glGetUniformLocation(m_idPSOStepProgram, "iConvergencePlateau");
+		}
+
+		m_idUpdateSwarmProgram = 0;
+		if(m_oConfig.sOptimizer == sOptimizerPSO && !m_oConfig.bFusedStep) {
+			m_idUpdateSwarmProgram = GetSpecializedProgram("update_swarm");
+			m_locSwarmDecoupledUniform =
+				glGetUniformLocation(m_idUpdateSwarmProgram, "bDecoupled");
+		}
+
+		m_idColorFragProgram =
+			m_pShaderReg->GetProgram("shaded_indexedtransform");
+		m_locColorUniform =
+			glGetUniformLocation(m_idColorFragProgram, "color_in");
+
+		glUseProgram(m_idColorFragProgram);
+		glUniform3f(m_locColorUniform, 1.0f, 0.0f, 0.0f);
+
+		m_locInitRandomSeedUniform =
+			glGetUniformLocation(m_idInitializeSwarmProgram, "iRandomSeed");
+		m_locInitRandomFrameUniform =
+			glGetUniformLocation(m_idInitializeSwarmProgram, "iRandomFrame");
+		m_locKeepKBestUniform =
+			glGetUniformLocation(m_idInitializeSwarmProgram, "iKeepKBest");
+		m_locResetMotionUniform =
+			glGetUniformLocation(m_idInitializeSwarmProgram, "bResetMotion");
+		m_locMotionDampingUniform =
+			glGetUniformLocation(m_idInitializeSwarmProgram, "fMotionDamping");
+		m_locMotionSpreadUniform =
+			glGetUniformLocation(m_idInitializeSwarmProgram, "fMotionSpread");
+		m_locHaltonUniform =
+			glGetUniformLocation(m_idInitializeSwarmProgram, "bHalton");
+		m_locInitDecoupledUniform =
+			glGetUniformLocation(m_idInitializeSwarmProgram, "bDecoupled");
+
+		return true;
+	}
+
+	GLuint HandTracker::GetSpecializedProgram(const std::string &sName) {
+		return m_pShaderReg->GetProgram(sName, m_mapShaderDefines);
+	}
+
+	GLuint HandTracker::GetSwarmProgram() {
+		ShaderRegistry::Defines mapDefines;
+		if(m_oConfig.bLayered)
+			mapDefines["LAYERED"] = "1";
+
+		return m_pShaderReg->GetProgram(
+			SwarmProgram(m_oConfig.bImpostors, m_oConfig.bStateTransforms,
+						 m_oConfig.bLayered),
+			mapDefines);
+	}
+
 	bool HandTracker::InitFrameFilter() {
 		m_pFrameFilter = new CameraFrameFilter(m_oConfig.iDilationSize,
 											   m_oConfig.iErosionSize,
@@ -545,48 +1185,98 @@ namespace rhapsodies {
 	}
 
 	bool HandTracker::InitRendering() {
-		// prepare texture and PBO for camera depth map
+		m_pHandRenderer = new HandRenderer(
+			m_pShaderReg->GetProgram(m_oConfig.bImpostors ?
+									 "impostor" : "indexedtransform"),
+			false, 4, m_oConfig.iSwarmSize, m_oConfig.bImpostors);
+
+		// the start pose match draws cpu side transforms into the
+		// first tile or layer, so the buffer renderer is kept for it
+		m_pSwarmRenderer = m_pHandRenderer;
+		if(m_oConfig.bStateTransforms || m_oConfig.bLayered) {
+			m_pSwarmRenderer = new HandRenderer(
+				GetSwarmProgram(), false, 4, m_oConfig.iSwarmSize,
+				m_oConfig.bImpostors, m_oConfig.bStateTransforms);
+		}
+
+		// prepare texture for camera depth map, one mipmap level per
+		// resolution level shared by all tiles. it is unpacked from
+		// the camera upload ring, see InitReduction().
 		glGenTextures(1, &m_idCameraTexture);
 		glBindTexture(GL_TEXTURE_2D, m_idCameraTexture);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+						GL_NEAREST_MIPMAP_NEAREST);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT16,
-					 320*8, 240*8, 0,
-					 GL_DEPTH_COMPONENT, GL_SHORT, NULL);
-
-		glGenBuffers(1, &m_idCameraTexturePBO);
-		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_idCameraTexturePBO);
-		glBufferData(GL_PIXEL_UNPACK_BUFFER,
-					 320*240*2, 0, GL_DYNAMIC_DRAW);
-		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL,
+						m_iResolutionLevels-1);
+		for(unsigned int level = 0; level < m_iResolutionLevels; ++level) {
+			glTexImage2D(GL_TEXTURE_2D, level, GL_DEPTH_COMPONENT16,
+						 320 >> level, 240 >> level, 0,
+						 GL_DEPTH_COMPONENT, GL_SHORT, NULL);
+		}
 
 		// prepare FBO rendering
 		glGenTextures(1, &m_idRenderedTexture);
-		glBindTexture(GL_TEXTURE_2D, m_idRenderedTexture);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		if(m_oConfig.bLayered) {
+			glBindTexture(GL_TEXTURE_2D_ARRAY, m_idRenderedTexture);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER,
+							GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER,
+							GL_NEAREST);
+			// immutable for the inspection view
+			glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_DEPTH_COMPONENT16,
+						   320, 240, m_oConfig.iSwarmSize);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+			glGenTextures(1, &m_idRenderedTextureView);
+			glTextureView(m_idRenderedTextureView, GL_TEXTURE_2D,
+						  m_idRenderedTexture, GL_DEPTH_COMPONENT16,
+						  0, 1, 0, 1);
+		}
+		else {
+			glBindTexture(GL_TEXTURE_2D, m_idRenderedTexture);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT16,
-					 320*8, 240*8, 0,
-					 GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT16,
+						 320*m_iTilesX, 240*m_iTilesY, 0,
+						 GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+		}
 
 		glGenFramebuffers(1, &m_idRenderedTextureFBO);
 		glBindFramebuffer(GL_FRAMEBUFFER, m_idRenderedTextureFBO);
 
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
-							   GL_TEXTURE_2D, m_idRenderedTexture, 0);
+		// layered attachment, primitives without a layer go to the
+		// first one
+		if(m_oConfig.bLayered) {
+			glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+								 m_idRenderedTexture, 0);
+		}
+		else {
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+								   GL_TEXTURE_2D, m_idRenderedTexture, 0);
+		}
 
 		CheckFrameBufferStatus(m_idRenderedTextureFBO);
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-		// prepare constant viewport data array
-		for(int row = 0 ; row < 8 ; row++) {
-			for(int col = 0 ; col < 8 ; col++) {
-				size_t index = row*8 + col;
-				m_vViewportData[4*index+0] = col*320;
-				m_vViewportData[4*index+1] = row*240;
-				m_vViewportData[4*index+2] = 320;
-				m_vViewportData[4*index+3] = 240;
+		// prepare constant viewport data arrays, coarser levels use
+		// the top left part of the atlas
+		m_vViewportData.resize(m_iResolutionLevels);
+		for(unsigned int level = 0 ; level < m_iResolutionLevels ; level++) {
+			std::vector<float> &vViewportData = m_vViewportData[level];
+			unsigned int iWidth  = 320 >> level;
+			unsigned int iHeight = 240 >> level;
+
+			vViewportData.resize(4*m_oConfig.iSwarmSize);
+			for(unsigned int row = 0 ; row < m_iTilesY ; row++) {
+				for(unsigned int col = 0 ; col < m_iTilesX ; col++) {
+					size_t index = row*m_iTilesX + col;
+					vViewportData[4*index+0] = col*iWidth;
+					vViewportData[4*index+1] = row*iHeight;
+					vViewportData[4*index+2] = iWidth;
+					vViewportData[4*index+3] = iHeight;
+				}
 			}
 		}
 
@@ -597,26 +1287,29 @@ namespace rhapsodies {
 		// hand models SSBO
 		glGenBuffers(1, &m_idSSBOHandModels);
 		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_idSSBOHandModels);
-		// 32 instead of 27 for padding
-		glBufferData(GL_SHADER_STORAGE_BUFFER, 64*2*32*sizeof(float),
+		// see HandStateLayout for the padded per-particle state
+		glBufferData(GL_SHADER_STORAGE_BUFFER,
+					 m_oConfig.iSwarmSize*iStateSize*sizeof(float),
 					 NULL, GL_DYNAMIC_DRAW);
 
 		// hand models ibest SSBO
 		glGenBuffers(1, &m_idSSBOHandModelsIBest);
 		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_idSSBOHandModelsIBest);
-		glBufferData(GL_SHADER_STORAGE_BUFFER, 64*2*32*sizeof(float),
+		glBufferData(GL_SHADER_STORAGE_BUFFER,
+					 m_oConfig.iSwarmSize*iStateSize*sizeof(float),
 					 NULL, GL_DYNAMIC_DRAW);
 
 		// hand models velocity SSBO
 		glGenBuffers(1, &m_idSSBOHandModelsVelocity);
 		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_idSSBOHandModelsVelocity);
-		glBufferData(GL_SHADER_STORAGE_BUFFER, 64*2*32*sizeof(float),
+		glBufferData(GL_SHADER_STORAGE_BUFFER,
+					 m_oConfig.iSwarmSize*iStateSize*sizeof(float),
 					 NULL, GL_DYNAMIC_DRAW);
 
 		// hand models gbest SSBO
 		glGenBuffers(1, &m_idSSBOHandModelsGBest);
 		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_idSSBOHandModelsGBest);
-		glBufferData(GL_SHADER_STORAGE_BUFFER, 64*sizeof(float),
+		glBufferData(GL_SHADER_STORAGE_BUFFER, iStateSize*sizeof(float),
 					 NULL, GL_DYNAMIC_DRAW);
 
 		// hand geometry SSBO
@@ -625,17 +1318,22 @@ namespace rhapsodies {
 		glBufferData(GL_SHADER_STORAGE_BUFFER, 19*sizeof(float),
 					 &m_pHandGeometry->GetExtents()[0], GL_DYNAMIC_DRAW);
 
-		// random number SSBO
-		glGenBuffers(1, &m_idSSBORandom);
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_idSSBORandom);
-		glBufferData(GL_SHADER_STORAGE_BUFFER, 64*64*8*sizeof(float),
-					 NULL, GL_DYNAMIC_DRAW);
-		float *aRandom = (float*)(glMapBuffer(GL_SHADER_STORAGE_BUFFER,
-											  GL_WRITE_ONLY));
-		for(int i = 0; i < 64*64*8; ++i) {
-			aRandom[i] = m_pRNG->GenerateFloat2();
-		}
-		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+		// convergence SSBO
+		glGenBuffers(1, &m_idSSBOConvergence);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_idSSBOConvergence);
+		std::vector<float> vecConvergence(
+			iConvergenceHeaderSize + m_oConfig.iSwarmSize, 0.0f);
+		glBufferData(GL_SHADER_STORAGE_BUFFER,
+					 vecConvergence.size()*sizeof(float),
+					 &vecConvergence[0], GL_DYNAMIC_DRAW);
+
+		// motion SSBO, previous gbest and its smoothed change
+		glGenBuffers(1, &m_idSSBOMotion);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_idSSBOMotion);
+		std::vector<float> vecMotion(2*iStateSize, 0.0f);
+		glBufferData(GL_SHADER_STORAGE_BUFFER,
+					 vecMotion.size()*sizeof(float),
+					 &vecMotion[0], GL_DYNAMIC_DRAW);
 
 		// debug SSBO
 		glGenBuffers(1, &m_idSSBODebug);
@@ -645,108 +1343,128 @@ namespace rhapsodies {
 		
 		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 
-		return true;
-	}
-
-	bool HandTracker::InitReduction() {
-		glActiveTexture(GL_TEXTURE0);
-
-		// prepare reduction textures
-		unsigned short *data = new unsigned short[320*256*8*8];
-		for(size_t i = 0; i < 320*256*8*8; ++i) {
-			data[i] = 0x0;
+		// transfer rings, the swarm rings hold hand models, velocity
+		// and ibest and for readbacks gbest
+		if(!GLEW_ARB_buffer_storage) {
+			vstr::warn() << "ARB_buffer_storage not supported, transfers "
+						 << "fall back to unsynchronized mapping." << std::endl;
 		}
-		unsigned int *data_uint = new unsigned int[320*256*8*8];
-		for(size_t i = 0; i < 320*256*8*8; ++i) {
-			data_uint[i] = 0x0;
+		size_t szSwarm = m_oConfig.iSwarmSize*iStateSize*sizeof(float);
+		m_pSwarmUpload = new TransferRing(TransferRing::UPLOAD, 3*szSwarm);
+		m_pSwarmReadback = new TransferRing(
+			TransferRing::READBACK, 3*szSwarm + iStateSize*sizeof(float));
+		m_pStartPoseReadback = new TransferRing(
+			TransferRing::READBACK, sizeof(float));
+		m_pGBestReadback = new TransferRing(
+			TransferRing::READBACK, iStateSize*sizeof(float));
+		m_pConvergenceReadback = new TransferRing(
+			TransferRing::READBACK, iConvergenceHeaderSize*sizeof(float));
+
+		if(m_oConfig.sOptimizer == sOptimizerCMAES) {
+			m_pOptimizer = new OptimizerCMAES(
+				GetSpecializedProgram("cmaes_update"),
+				GetSpecializedProgram("cmaes_sample"),
+				m_oConfig.iSwarmSize,
+				m_oConfig.fCMAESSigma,
+				m_oConfig.iRandomSeed);
 		}
-
-		// first step: 320x256
-		glGenTextures(3, m_idReductionTextures320x256);
-		for(size_t i = 0; i < 3; ++i) {
-			glBindTexture(GL_TEXTURE_2D, m_idReductionTextures320x256[i]);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-			glTexStorage2D(GL_TEXTURE_2D, 1, GL_R16UI, 320*8, 256*8);
-			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 320*8, 256*8, GL_RED_INTEGER,
-							GL_UNSIGNED_SHORT, data);
+		else {
+			OptimizerParticleSwarm::Parameters oParams;
+			oParams.iSwarmSize         = m_oConfig.iSwarmSize;
+			oParams.iGenerations       = m_oConfig.iPSOGenerations;
+			oParams.fPhiCognitiveBegin = m_oConfig.fPhiCognitiveBegin;
+			oParams.fPhiCognitiveEnd   = m_oConfig.fPhiCognitiveEnd;
+			oParams.fInertiaBegin      = m_oConfig.fInertiaBegin;
+			oParams.fInertiaEnd        = m_oConfig.fInertiaEnd;
+			oParams.bRingTopology      = m_oConfig.bRingTopology;
+			oParams.iRandomSeed        = m_oConfig.iRandomSeed;
+			oParams.bFused             = (m_idPSOStepProgram != 0);
+
+			m_pOptimizer = new OptimizerParticleSwarm(
+				oParams.bFused ? m_idPSOStepProgram : m_idUpdateSwarmProgram,
+				oParams);
 		}
-
-		// second step: 40x32
-		glGenTextures(3, m_idReductionTextures40x32);
-		for(size_t i = 0; i < 3; ++i) {
-			glBindTexture(GL_TEXTURE_2D, m_idReductionTextures40x32[i]);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-			glTexStorage2D(GL_TEXTURE_2D, 1, GL_R16UI, 40*8, 32*8);
-			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 40*8, 32*8, GL_RED_INTEGER,
-							GL_UNSIGNED_SHORT, data);
+		vstr::debug() << "Optimizer: " << m_pOptimizer->GetName()
+					  << std::endl;
+
+		if(m_oConfig.iRefineSteps > 0) {
+			m_pRefinement = new LevenbergMarquardt(
+				GetSpecializedProgram("refine_jacobian"),
+				GetSpecializedProgram("refine_solve"),
+				GetSpecializedProgram("refine_accept"),
+				m_oConfig.fRefineDifferenceStep,
+				m_oConfig.fRefineDamping);
 		}
 
-		// third step: 5x4
-		glGenTextures(3, m_idReductionTextures5x4);
-		glBindTexture(GL_TEXTURE_2D, m_idReductionTextures5x4[0]);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		return true;
+	}
 
-		glTexStorage2D(GL_TEXTURE_2D, 1, GL_R32UI, 5*8, 4*8);
-		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 5*8, 4*8, GL_RED_INTEGER,
-						GL_UNSIGNED_SHORT, data_uint);
-		for(size_t i = 1; i < 3; ++i) {
-			glBindTexture(GL_TEXTURE_2D, m_idReductionTextures5x4[i]);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	bool HandTracker::InitReduction() {
+		// per particle sums, cleared before each reduction
+		glGenBuffers(1, &m_idSSBOReduction);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_idSSBOReduction);
+		glBufferData(GL_SHADER_STORAGE_BUFFER,
+					 m_oConfig.iSwarmSize*iReductionResultSize*sizeof(GLuint),
+					 NULL, GL_DYNAMIC_DRAW);
 
-			glTexStorage2D(GL_TEXTURE_2D, 1, GL_R16UI, 5*8, 4*8);
-			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 5*8, 4*8, GL_RED_INTEGER,
-							GL_UNSIGNED_SHORT, data);
-		}
+		// camera silhouette per frame, see UploadCameraDepthMap()
+		size_t szColumns =
+			m_iResolutionLevels*iCameraColumnEntries*sizeof(GLuint);
+		glGenBuffers(1, &m_idSSBOCamera);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_idSSBOCamera);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, szColumns,
+					 NULL, GL_DYNAMIC_DRAW);
+		glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI,
+						  GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 
-		// fourth step: 1x1
-		glGenTextures(3, m_idReductionTextures1x1);
-		for(size_t i = 0; i < 3; ++i) {
-			glBindTexture(GL_TEXTURE_2D, m_idReductionTextures1x1[i]);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		// column counts followed by the camera depth pyramid
+		m_pCameraUpload = new TransferRing(
+			TransferRing::UPLOAD,
+			szColumns +
+			PyramidLevelOffset(m_iResolutionLevels)*sizeof(unsigned short));
 
-			glTexStorage2D(GL_TEXTURE_2D, 1, GL_R32UI, 8, 8);
-			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 8, 8, GL_RED_INTEGER,
-							GL_UNSIGNED_INT, data_uint);
-		}
+		// the difference inspection texture is created on demand,
+		// see SetInspectDifference()
 
+		ValidateComputeShader(m_idReduceDepthMapsProgram);
+
+		return true;
+	}
+	
+	bool HandTracker::InitDifferenceTexture() {
+		const unsigned int tx = m_iTilesX;
+		const unsigned int ty = m_iTilesY;
 
-		// difference inspection texture
 		glGenTextures(1, &m_idDifferenceTexture);
 
 		glBindTexture(GL_TEXTURE_2D, m_idDifferenceTexture);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
-		glTexStorage2D(GL_TEXTURE_2D, 1, GL_R16UI, 320*8, 240*8);
-		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 320*8, 240*8, GL_RED_INTEGER,
-						GL_UNSIGNED_SHORT, data);
-		
-		delete [] data;
-
-		ValidateComputeShader(m_idReduction0DifferenceProgram);
-		ValidateComputeShader(m_idReduction1DifferenceProgram);
-		ValidateComputeShader(m_idReduction2DifferenceProgram);
-		ValidateComputeShader(m_idReduction0UnionProgram);
-		ValidateComputeShader(m_idReduction1UnionProgram);
-		ValidateComputeShader(m_idReduction2UnionProgram);
-		ValidateComputeShader(m_idReduction0IntersectionProgram);
-		ValidateComputeShader(m_idReduction1IntersectionProgram);
-		ValidateComputeShader(m_idReduction2IntersectionProgram);
+		glTexStorage2D(GL_TEXTURE_2D, 1, GL_R16UI, 320*tx, 240*ty);
+		if(GLEW_ARB_clear_texture) {
+			glClearTexImage(m_idDifferenceTexture, 0, GL_RED_INTEGER,
+							GL_UNSIGNED_SHORT, NULL);
+		}
+		else {
+			std::vector<unsigned short> vecZero(320*240*tx*ty, 0);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 320*tx, 240*ty,
+							GL_RED_INTEGER, GL_UNSIGNED_SHORT, &vecZero[0]);
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
 
 		return true;
 	}
 	
 	bool HandTracker::InitParticleSwarm() {
-		m_pSwarm = new ParticleSwarm(64);
+		m_pSwarm = new ParticleSwarm(m_oConfig.iSwarmSize);
+		m_pSwarm->SetMotionModel(m_oConfig.fMotionDamping,
+								 m_oConfig.fMotionSpread);
 		SetToInitialPose(m_pSwarm->GetParticleBest());
-		m_pSwarm->InitializeAroundBest(0);
+		m_pSwarm->SetRandomSeed(m_oConfig.iRandomSeed);
+		m_pSwarm->SetHaltonSpread(m_oConfig.bHaltonSpread);
+		m_pSwarm->InitializeAroundBest(0, 0);
 		
 		return true;
 	}
@@ -767,6 +1485,14 @@ namespace rhapsodies {
 
 		PrepareEvaluationFiles();
 
+		// penalties of the whole swarm and gbest per generation and
+		// refinement batch. the results of up to two frames may be in
+		// flight.
+		m_pEvaluationReadback = new TransferRing(
+			TransferRing::READBACK,
+			(m_oConfig.iSwarmSize + 1)*iStateSize*sizeof(float),
+			2*(m_oConfig.iPSOGenerations + 2*m_oConfig.iRefineSteps + 1));
+
 		m_pFramePlayer->SetInputFile(*m_itCurPlayback);
 		m_pFramePlayer->StartPlayback();
 
@@ -789,6 +1515,14 @@ namespace rhapsodies {
 		m_osEvalOutput.open(sEvalOutput+sEvalOutputSuffix,
 							std::ios_base::out | std::ios_base::binary);
 
+		// gbest penalty over evaluated candidates, to compare
+		// optimizers, see benchmark-optimizers.sh
+		if(m_osBenchOutput.is_open())
+			m_osBenchOutput.close();
+		m_osBenchOutput.open(sEvalOutput+sBenchOutputSuffix);
+		m_osBenchOutput << "# frame generation evaluations penalty "
+						<< m_oConfig.sOptimizer << std::endl;
+
 		std::ofstream osEvalConfig;
 		osEvalConfig.open(sEvalOutput+".txt");
 		PrintConfig(osEvalConfig);
@@ -894,12 +1628,6 @@ namespace rhapsodies {
 
 		ResourcesUnbind();
 
-		//m_pProfiler->PrintProfile(vstr::out());
-		// vstr::out()
-		// 	<< "Reduction time: "
-		// 	<< m_pProfiler->GetRoot()->GetChild("Reduction")->GetLastFrameTime()
-		// 	<< std::endl;			
-
 		return true;
 	}
 
@@ -929,30 +1657,7 @@ namespace rhapsodies {
 	void HandTracker::ResourcesBind() {
 		glBindFramebuffer(GL_FRAMEBUFFER, m_idRenderedTextureFBO);	
 
-		// bind result image textures
-		for(size_t i = 0; i < 3; ++i) {
-			glBindImageTexture(0 + i,
-							   m_idReductionTextures320x256[i],
-							   0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R16UI);
-		}
-		for(size_t i = 0; i < 3; ++i) {
-			glBindImageTexture(3 + i,
-							   m_idReductionTextures40x32[i],
-							   0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R16UI);
-		}
-		glBindImageTexture(6,
-						   m_idReductionTextures5x4[0],
-						   0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32UI);
-		for(size_t i = 1; i < 3; ++i) {
-			glBindImageTexture(6 + i,
-							   m_idReductionTextures5x4[i],
-							   0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R16UI);
-		}
-		for(size_t i = 0; i < 3; ++i) {
-			glBindImageTexture(9 + i,
-							   m_idReductionTextures1x1[i],
-							   0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32UI);
-		}
+		// bind result image texture
 		glBindImageTexture(12, m_idDifferenceTexture,
 						   0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R16UI);
 
@@ -960,12 +1665,8 @@ namespace rhapsodies {
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_2D, m_idCameraTexture);
 		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, m_idRenderedTexture);
+		glBindTexture(GetRenderedTextureTarget(), m_idRenderedTexture);
 
-#ifndef PSO_TESTING		
-		// bind pixel unpack PBO
-		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_idCameraTexturePBO);
-#endif
 		// bind transform SSBOs
 		glBindBufferBase(GL_SHADER_STORAGE_BUFFER,
 						 iSSBOHandModelsLocation,
@@ -986,8 +1687,17 @@ namespace rhapsodies {
 						 iSSBOHandModelsVelocityLocation,
 						 m_idSSBOHandModelsVelocity);
 		glBindBufferBase(GL_SHADER_STORAGE_BUFFER,
-						 iSSBORandomLocation,
-						 m_idSSBORandom);
+						 iSSBOConvergenceLocation,
+						 m_idSSBOConvergence);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER,
+						 iSSBOMotionLocation,
+						 m_idSSBOMotion);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER,
+						 iSSBOReductionLocation,
+						 m_idSSBOReduction);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER,
+						 iSSBOCameraLocation,
+						 m_idSSBOCamera);
 	}
 
 	void HandTracker::ResourcesUnbind() {
@@ -1005,46 +1715,156 @@ namespace rhapsodies {
 		glBindBufferBase(GL_SHADER_STORAGE_BUFFER,
 						 iSSBOHandModelsVelocityLocation, 0);
 		glBindBufferBase(GL_SHADER_STORAGE_BUFFER,
-						 iSSBORandomLocation, 0);
-
-#ifndef PSO_TESTING		
-		// unbind pixel unpack PBO
- 		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
-#endif
+						 iSSBOConvergenceLocation, 0);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER,
+						 iSSBOMotionLocation, 0);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER,
+						 iSSBOReductionLocation, 0);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER,
+						 iSSBOCameraLocation, 0);
 		
 		// unbind input textures
 		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, 0);
+		glBindTexture(GetRenderedTextureTarget(), 0);
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_2D, 0);
 
-		// unbind result image textures
+		// unbind result image texture
 		glBindImageTexture(12, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R16UI);
-		for(size_t i = 0; i < 12; ++i) {
-			glBindImageTexture(i, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R16UI);
-		}
 
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
 	}
 	
 	void HandTracker::UploadCameraDepthMap() {
-		// upload camera image to tiled texture
- 		unsigned short *aCameraTexturePBO =
-			(unsigned short*)glMapBuffer(GL_PIXEL_UNPACK_BUFFER,
-										 GL_WRITE_ONLY);		
-		memcpy(aCameraTexturePBO, m_pDepthBuffer,
+		// the upload region holds the camera column counts followed by
+		// the camera image pyramid
+		size_t szColumns =
+			m_iResolutionLevels*iCameraColumnEntries*sizeof(GLuint);
+		unsigned char *aRegion = (unsigned char*)m_pCameraUpload->Map();
+
+		// the camera silhouette is the same for all tiles and
+		// generations of a frame. reduce_depth_maps.comp takes the
+		// camera part of the union from the column counts and only
+		// samples the camera under the rendered silhouette.
+		GLuint *aColumnsRegion = (GLuint*)aRegion;
+		for(unsigned int level = 0 ; level < m_iResolutionLevels ; level++) {
+			GLuint *aColumns = aColumnsRegion + level*iCameraColumnEntries;
+			unsigned int iWidth  = 320 >> level;
+			unsigned int iHeight = 240 >> level;
+
+			// the region is reused, unused entries are zeroed
+			std::fill(aColumns, aColumns + iCameraColumnEntries, 0);
+			for(unsigned int x = 0 ; x < iWidth ; x++) {
+				GLuint iCount = 0;
+				for(unsigned int y = 0 ; y < iHeight ; y++) {
+					if(IsCameraForeground(
+						   m_pDepthBuffer[(y << level)*320 + (x << level)]))
+						iCount++;
+				}
+				aColumns[x+1] = aColumns[x] + iCount;
+			}
+		}
+
+		// camera image pyramid, the tiles sample it with tile local
+		// coordinates. coarser levels are point sampled to keep depth
+		// edges sharp.
+		unsigned short *aCameraPyramid =
+			(unsigned short*)(aRegion + szColumns);
+		memcpy(aCameraPyramid, m_pDepthBuffer,
 			   320*240*sizeof(unsigned short));
-		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		for(unsigned int level = 1 ; level < m_iResolutionLevels ; level++) {
+			unsigned short *aLevel =
+				aCameraPyramid + PyramidLevelOffset(level);
+			unsigned int iWidth  = 320 >> level;
+			unsigned int iHeight = 240 >> level;
+
+			for(unsigned int y = 0 ; y < iHeight ; y++) {
+				for(unsigned int x = 0 ; x < iWidth ; x++) {
+					aLevel[y*iWidth + x] =
+						m_pDepthBuffer[(y << level)*320 + (x << level)];
+				}
+			}
+		}
+		m_pCameraUpload->Unmap();
 
+		m_pCameraUpload->CopyTo(m_idSSBOCamera, 0, 0, szColumns);
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pCameraUpload->GetBufferId());
 		glActiveTexture(GL_TEXTURE0);
-		for(int row = 0 ; row < 8 ; row++) {
-			for(int col = 0 ; col < 8 ; col++) {
-				glTexSubImage2D(GL_TEXTURE_2D, 0, 
-								320*col, 240*row, 320, 240,
-								GL_DEPTH_COMPONENT,
-								GL_SHORT, NULL);
-			}
+		for(unsigned int level = 0 ; level < m_iResolutionLevels ; level++) {
+			unsigned int iWidth  = 320 >> level;
+			unsigned int iHeight = 240 >> level;
+			size_t szOffset = m_pCameraUpload->GetOffset() + szColumns +
+				PyramidLevelOffset(level)*sizeof(unsigned short);
+			
+			glTexSubImage2D(GL_TEXTURE_2D, level,
+							0, 0, iWidth, iHeight,
+							GL_DEPTH_COMPONENT,
+							GL_SHORT, (GLvoid*)szOffset);
 		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		m_pCameraUpload->Submit();
+	}
+
+	unsigned int HandTracker::GetResolutionLevel(unsigned int iGeneration) {
+		// the schedule entries split the generations evenly
+		const std::vector<int> &vecSchedule = m_oConfig.vecResolutionSchedule;
+		if(m_oConfig.iPSOGenerations == 0)
+			return vecSchedule.back();
+		
+		return vecSchedule[iGeneration * vecSchedule.size() /
+						   m_oConfig.iPSOGenerations];
+	}
+
+	void HandTracker::UpdateHandSeparation() {
+		// the cpu swarm re-initialization and CMA-ES only rank by
+		// the joint penalty, sub-swarms need the gpu path to
+		// assemble gbest
+		m_bDecoupledHands = false;
+		if(!m_oConfig.bDecoupleHands || !m_oConfig.bGpuSwarmInit ||
+		   m_oConfig.sOptimizer != sOptimizerPSO)
+			return;
+
+		// screen space extents of both hands around the last fetched
+		// gbest positions, following the projection of
+		// SetupProjection(). the smoothed output models would lag
+		// behind the hands.
+		float cx = m_oCameraIntrinsics.GetValue<float>("CX");
+		float fx = m_oCameraIntrinsics.GetValue<float>("FX");
+
+		Particle &oGBest = m_pSwarm->GetParticleBest();
+		HandModel *pModels[2] = { oGBest.GetHandModelLeft(),
+								  oGBest.GetHandModelRight() };
+		float fCenter[2];
+		float fExtent[2];
+		for(int hand = 0; hand < 2; ++hand) {
+			VistaVector3D vPos = pModels[hand]->GetPosition();
+			if(vPos[2] <= 0.0f)
+				return;
+
+			fCenter[hand] = cx - fx*vPos[0]/vPos[2];
+			fExtent[hand] = fx*fHandBoundingRadius/vPos[2];
+		}
+
+		m_bLeftHandFirst = fCenter[0] < fCenter[1];
+		int iFirst  = m_bLeftHandFirst ? 0 : 1;
+		int iSecond = 1 - iFirst;
+
+		float fGapBegin = fCenter[iFirst]  + fExtent[iFirst];
+		float fGapEnd   = fCenter[iSecond] - fExtent[iSecond];
+
+		// the split is pixel exact, on coarser resolution levels it
+		// moves to the left by less than 2^level pixels
+		if(fGapEnd - fGapBegin < float(m_oConfig.iDecoupleMinGap))
+			return;
+
+		float fSplit = 0.5f*(fGapBegin + fGapEnd);
+		if(fSplit <= 0.0f || fSplit >= 320.0f)
+			return;
+
+		m_iSplitPixel = (unsigned int)(fSplit);
+		m_bDecoupledHands = true;
 	}
 
 	void HandTracker::SetupProjection() {
@@ -1062,8 +1882,8 @@ namespace rhapsodies {
 		fy /= 1000.0f;		
 
 		// https://sightations.wordpress.com/2010/08/03/simulating-calibrated-cameras-in-opengl/
-		float znear = 0.1f;
-		float zfar  = 1.1f;
+		float znear = fZNear;
+		float zfar  = fZFar;
 		float x = znear + zfar;
 		float y = znear * zfar;
 
@@ -1117,15 +1937,30 @@ namespace rhapsodies {
 		m_pHandRenderer->PerformDraw(true, 0, 1, &vViewportData[0]);
 		m_pHandRenderer->PostDraw();
 
-		ReduceDepthMaps();
-		UpdateScores();
-
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_idSSBOHandModelsIBest);
-		float *pModelsIBest = (float*)(glMapBuffer(GL_SHADER_STORAGE_BUFFER,
-												   GL_READ_ONLY));
-		float fPenalty = pModelsIBest[31];
-		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);		
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		ReduceDepthMaps(0);
+		UpdateScores(false, true);
+
+		m_pStartPoseReadback->CopyFrom(
+			m_idSSBOHandModelsIBest,
+			HandStateLayout::iPenaltyOffset*sizeof(float),
+			0, sizeof(float));
+		m_pStartPoseReadback->Submit();
+
+		// interactive runs use the latest penalty the gpu is done
+		// with, usually the one of the previous frame. repeatable
+		// runs wait for this frame's, so tracking starts on the same
+		// frame every run.
+		bool bWait = GetWaitForReadbacks();
+		bool bFetched = false;
+		float fPenalty = 0.0f;
+		while(const float *pPenalty =
+			  (const float*)m_pStartPoseReadback->Fetch(bWait)) {
+			fPenalty = *pPenalty;
+			bFetched = true;
+			m_pStartPoseReadback->Release();
+		}
+		if(!bFetched)
+			return;
 
 		float fRed = PenaltyNormalize(fPenalty);
 		float fGreen = 1 - fRed;
@@ -1143,86 +1978,143 @@ namespace rhapsodies {
 	}
 
 	void HandTracker::PerformPSOTracking() {
-		const VistaTimer &oTimer = VistaTimeUtils::GetStandardTimer();
-		VistaType::microtime tStart = 0.0;
-		VistaType::microtime tTransform = 0.0;
-		VistaType::microtime tRendering = 0.0;
-		VistaType::microtime tReduction = 0.0;
-		VistaType::microtime tSwarmUpdate = 0.0;
-
-		UploadHandModels();
+		// stage times are taken on the gpu, see GpuProfiler
+		m_pGpuProfiler->BeginStage(GpuProfiler::FRAME);
+
+		// a freshly uploaded swarm has no motion history
+		bool bResetMotion = m_bSwarmUploadPending;
+		if(!m_oConfig.bGpuSwarmInit || m_bSwarmUploadPending) {
+			UploadHandModels();
+			m_bSwarmUploadPending = false;
+		}
 		
-		float fPhiCognitive;
-		float fPhiSocial;
-		for(unsigned gen = 0 ; gen < m_oConfig.iPSOGenerations ; gen++) {
-			tStart = oTimer.GetMicroTime();
+		unsigned int iLevel = GetResolutionLevel(0);
+		unsigned int iFinalLevel =
+			GetResolutionLevel(std::max(m_oConfig.iPSOGenerations, 1u) - 1);
+		unsigned int gen = 0;
+
+		UpdateHandSeparation();
+
+		ResetConvergenceReadback();
+		for( ; gen < m_oConfig.iPSOGenerations ; gen++) {
+			// coarse-to-fine: ibest penalties are re-evaluated on
+			// the first generation of each new level
+			unsigned int iGenLevel = GetResolutionLevel(gen);
+			bool bLevelChanged = (iGenLevel != iLevel);
+			iLevel = iGenLevel;
+
+			if(bLevelChanged)
+				ResetConvergenceReadback();
+			
+			m_pGpuProfiler->BeginStage(GpuProfiler::GENERATION);
+
+			m_pGpuProfiler->BeginStage(GpuProfiler::TRANSFORM);
 			GenerateTransforms();
-			tTransform += oTimer.GetMicroTime() - tStart;
-
-			// FBO rendering of tiled zbuffers
-			tStart = oTimer.GetMicroTime();
-			glClear(GL_DEPTH_BUFFER_BIT);
-			m_pHandRenderer->PreDraw();
-			for(int row = 0 ; row < 8 ; row++) {
-				for(int col = 0 ; col < 8 ; col++) {
-					size_t index = row*8 + col;
-
-					if( (index+1) % m_oConfig.iViewportBatch == 0 ) {
-						m_pHandRenderer->PerformDraw(
-							false,
-							index/m_oConfig.iViewportBatch *
-							m_oConfig.iViewportBatch,
-							m_oConfig.iViewportBatch,
-							&m_vViewportData[0]);
-					}
-				}
-			}
-			m_pHandRenderer->PostDraw();
-			glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT);
-			tRendering += oTimer.GetMicroTime() - tStart;
+			m_pGpuProfiler->EndStage(GpuProfiler::TRANSFORM);
+
+			m_pGpuProfiler->BeginStage(GpuProfiler::RENDER);
+			RenderSwarm(iLevel);
+			m_pGpuProfiler->EndStage(GpuProfiler::RENDER);
 			
-			tStart = oTimer.GetMicroTime();
-			ReduceDepthMaps();
-			tReduction += oTimer.GetMicroTime() - tStart;
+			m_pGpuProfiler->BeginStage(GpuProfiler::REDUCTION);
+			ReduceDepthMaps(iLevel);
+			m_pGpuProfiler->EndStage(GpuProfiler::REDUCTION);
 			
-			tStart = oTimer.GetMicroTime();
-			UpdateScores();
-
-			fPhiCognitive = m_oConfig.fPhiCognitiveBegin +
-				float(gen)/float(m_oConfig.iPSOGenerations-1) *
-				(m_oConfig.fPhiCognitiveEnd - m_oConfig.fPhiCognitiveBegin);
-			fPhiSocial = 4.1f - fPhiCognitive;
+			m_pGpuProfiler->BeginStage(GpuProfiler::SWARM_UPDATE);
+			if(m_idPSOStepProgram)
+				PrepareFusedStep(bLevelChanged, gen == 0 || bLevelChanged);
+			else
+				UpdateScores(bLevelChanged, gen == 0 || bLevelChanged);
+			m_pOptimizer->Step(m_iRandomFrame, gen);
+			m_pGpuProfiler->EndStage(GpuProfiler::SWARM_UPDATE);
 
-			UpdateSwarm(fPhiCognitive, fPhiSocial);
-			tSwarmUpdate += oTimer.GetMicroTime() - tStart;
+			m_pGpuProfiler->EndStage(GpuProfiler::GENERATION);
 
 			if(m_oConfig.bEvaluate)
-				EvaluationStep();
+				EvaluationStep(gen);
+
+			// early termination on the final resolution level. the
+			// flag is read back at least one generation behind,
+			// without waiting for the gpu the lag depends on its
+			// timing, see FetchConvergenceReadback().
+			if(m_oConfig.iConvergencePlateau > 0 && iLevel == iFinalLevel) {
+				bool bConverged = FetchConvergenceReadback();
+				QueueConvergenceReadback();
+
+				if(bConverged) {
+					gen++;
+					break;
+				}
+			}
+		}
+
+		// decoupled gbest is assembled from per hand penalties, the
+		// refinement works on the joint penalty
+		if(m_pRefinement && !m_bDecoupledHands) {
+			m_pGpuProfiler->BeginStage(GpuProfiler::REFINEMENT);
+			RefineGBest(iFinalLevel, gen);
+			m_pGpuProfiler->EndStage(GpuProfiler::REFINEMENT);
+		}
+
+		if(m_oConfig.bGpuSwarmInit) {
+			// keep the swarm on the gpu, only fetch gbest for output
+			QueueGBestReadback();
+			InitializeSwarmGpu(bResetMotion);
+
+			if(FetchGBestReadback())
+				SmoothOutputModel();
+		}
+		else {
+			// fetches gbest along with the swarm
+			DownloadHandModels();
+			SmoothOutputModel();
 		}
 
-		DownloadHandModels();
-		UpdateOutputModel();
+		m_pGpuProfiler->EndStage(GpuProfiler::FRAME);
+		m_pGpuProfiler->EndFrame();
 
 		EvaluationPostFrame();
 
-		m_pSwarm->InitializeAroundBest(m_oConfig.iKeepKBest);
-		
+		if(!m_oConfig.bGpuSwarmInit)
+			m_pSwarm->InitializeAroundBest(m_oConfig.iKeepKBest,
+										   m_iRandomFrame);
+
+		m_iRandomFrame++;
+
+		// gpu times of the previous frames, mean (min, p99)
 		WriteDebug(IDebugView::TRANSFORM_TIME,
-				   IDebugView::FormatString("Transform time: ",
-											tTransform));
+				   IDebugView::FormatString(
+					   "Transform time: ",
+					   m_pGpuProfiler->FormatStage(GpuProfiler::TRANSFORM)));
 		WriteDebug(IDebugView::RENDER_TIME,
-				   IDebugView::FormatString("Render time: ",
-											tRendering));
-
-		VistaType::microtime tReductionProfiler =
-			m_pProfiler->GetRoot()->GetChild("Reduction")->GetLastFrameTime();
+				   IDebugView::FormatString(
+					   "Render time: ",
+					   m_pGpuProfiler->FormatStage(GpuProfiler::RENDER)));
 		WriteDebug(IDebugView::REDUCTION_TIME,
-				   IDebugView::FormatString("Reduction time: ",
-											tReductionProfiler));
-					   
+				   IDebugView::FormatString(
+					   "Reduction time: ",
+					   m_pGpuProfiler->FormatStage(GpuProfiler::REDUCTION)));
 		WriteDebug(IDebugView::SWARMUPDATE_TIME,
-				   IDebugView::FormatString("Swarm update time: ",
-											tSwarmUpdate));
+				   IDebugView::FormatString(
+					   "Swarm update time: ",
+					   m_pGpuProfiler->FormatStage(GpuProfiler::SWARM_UPDATE)));
+		WriteDebug(IDebugView::GENERATION_TIME,
+				   IDebugView::FormatString(
+					   "Generation time: ",
+					   m_pGpuProfiler->FormatStage(GpuProfiler::GENERATION)));
+		WriteDebug(IDebugView::GPU_FRAME_TIME,
+				   IDebugView::FormatString(
+					   "GPU frame time: ",
+					   m_pGpuProfiler->FormatStage(GpuProfiler::FRAME)));
+		if(m_pGpuProfiler->GetHasPipelineStatistics()) {
+			WriteDebug(IDebugView::RENDER_FRAGMENTS,
+					   IDebugView::FormatString(
+						   "Rendered fragments: ",
+						   m_pGpuProfiler->FormatCounter(
+							   GpuProfiler::FRAGMENTS)));
+		}
+		WriteDebug(IDebugView::PSO_GENERATIONS,
+				   IDebugView::FormatString("PSO generations: ", gen));
 
 		WriteDebug(IDebugView::PENALTY,
 				   IDebugView::FormatString(
@@ -1232,204 +2124,215 @@ namespace rhapsodies {
 	}
 
 	void HandTracker::UploadHandModels() {
-		ParticleSwarm::ParticleVec &vecParticles = m_pSwarm->GetParticles();
-		float *aBuffer;
+		// the swarm store uses the SSBO layout, so each buffer is a
+		// single contiguous copy
+		size_t iBufferSize =
+			m_pSwarm->GetParticleCount()*iStateSize*sizeof(float);
+		unsigned char *aRegion = (unsigned char*)m_pSwarmUpload->Map();
+
+		// stage HandModel, HandModelVelocity and HandModelIBest with
+		// reset penalties
+		m_pSwarm->ResetIBestPenalties();
+		memcpy(aRegion, m_pSwarm->GetStates(), iBufferSize);
+		memcpy(aRegion + iBufferSize, m_pSwarm->GetVelocities(), iBufferSize);
+		memcpy(aRegion + 2*iBufferSize, m_pSwarm->GetIBestStates(),
+			   iBufferSize);
+		m_pSwarmUpload->Unmap();
+
+		m_pSwarmUpload->CopyTo(m_idSSBOHandModels, 0, 0, iBufferSize);
+		m_pSwarmUpload->CopyTo(m_idSSBOHandModelsVelocity, 0,
+							   iBufferSize, iBufferSize);
+		m_pSwarmUpload->CopyTo(m_idSSBOHandModelsIBest, 0,
+							   2*iBufferSize, iBufferSize);
+		m_pSwarmUpload->Submit();
+	}
 
-		// upload HandModel
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_idSSBOHandModels);
-		aBuffer = (float*)glMapBuffer(GL_SHADER_STORAGE_BUFFER, GL_WRITE_ONLY);
-		for(int row = 0 ; row < 8 ; row++) {
-			for(int col = 0 ; col < 8 ; col++) {
-				size_t index = row*8+col;
-				Particle::ParticleToStateArray(&vecParticles[index],
-											   aBuffer + 64*index);
-			}
-		}
-		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+	void HandTracker::DownloadHandModels() {
+		// the cpu swarm needs the results of this frame, this is the
+		// only readback that waits for the gpu
+		size_t iBufferSize =
+			m_pSwarm->GetParticleCount()*iStateSize*sizeof(float);
+
+		m_pSwarmReadback->CopyFrom(m_idSSBOHandModels, 0, 0, iBufferSize);
+		m_pSwarmReadback->CopyFrom(m_idSSBOHandModelsVelocity, 0,
+								   iBufferSize, iBufferSize);
+		m_pSwarmReadback->CopyFrom(m_idSSBOHandModelsIBest, 0,
+								   2*iBufferSize, iBufferSize);
+		m_pSwarmReadback->CopyFrom(m_idSSBOHandModelsGBest, 0,
+								   3*iBufferSize, iStateSize*sizeof(float));
+		m_pSwarmReadback->Submit();
+
+		const unsigned char *aRegion =
+			(const unsigned char*)m_pSwarmReadback->Fetch(true);
+
+		memcpy(m_pSwarm->GetStates(), aRegion, iBufferSize);
+		memcpy(m_pSwarm->GetVelocities(), aRegion + iBufferSize, iBufferSize);
+		memcpy(m_pSwarm->GetIBestStates(), aRegion + 2*iBufferSize,
+			   iBufferSize);
+		Particle::StateArrayToParticle(
+			&m_pSwarm->GetParticleBest(),
+			(const float*)(aRegion + 3*iBufferSize));
 
-		// upload HandModelVelocity
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_idSSBOHandModelsVelocity);
-		aBuffer = (float*)glMapBuffer(GL_SHADER_STORAGE_BUFFER, GL_WRITE_ONLY);
-		for(int row = 0 ; row < 8 ; row++) {
-			for(int col = 0 ; col < 8 ; col++) {
-				size_t index = row*8+col;
-				memcpy(aBuffer + 64*index,
-					   &vecParticles[index].GetVelocity()[0],
-					   64*sizeof(float));
-			}
-		}
-		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
-		
-		// reset HandModelIBest penalty
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_idSSBOHandModelsIBest);
-		aBuffer = (float*)glMapBuffer(GL_SHADER_STORAGE_BUFFER, GL_WRITE_ONLY);
-		for(int row = 0 ; row < 8 ; row++) {
-			for(int col = 0 ; col < 8 ; col++) {
-				size_t index = row*8+col;
-				aBuffer[64*index + 31] = 1e20;
-			}
-		}
-		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+		m_pSwarmReadback->Release();
+	}
 
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	void HandTracker::InitializeSwarmGpu(bool bResetMotion) {
+		// keep k best, set one particle to the motion predicted gbest
+		// and randomize the rest around it
+		glUseProgram(m_idInitializeSwarmProgram);
+
+		glUniform1ui(m_locInitRandomSeedUniform, m_oConfig.iRandomSeed);
+		glUniform1ui(m_locInitRandomFrameUniform, m_iRandomFrame);
+		glUniform1ui(m_locKeepKBestUniform, m_oConfig.iKeepKBest);
+		glUniform1i(m_locResetMotionUniform, bResetMotion);
+		glUniform1f(m_locMotionDampingUniform, m_oConfig.fMotionDamping);
+		glUniform1f(m_locMotionSpreadUniform, m_oConfig.fMotionSpread);
+		glUniform1i(m_locHaltonUniform, m_oConfig.bHaltonSpread);
+		glUniform1i(m_locInitDecoupledUniform, m_bDecoupledHands);
+
+		glDispatchCompute(1, 1, 1);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
 	}
 
-	void HandTracker::DownloadHandModels() {
-		ParticleSwarm::ParticleVec &vecParticles = m_pSwarm->GetParticles();
-		float *aBuffer;
+	void HandTracker::QueueGBestReadback() {
+		// copy gbest into the readback ring on the gpu timeline
+		m_pGBestReadback->CopyFrom(m_idSSBOHandModelsGBest, 0, 0,
+								   iStateSize*sizeof(float));
+		m_pGBestReadback->Submit();
+	}
 
-		// download HandModel
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_idSSBOHandModels);
-		aBuffer = (float*)glMapBuffer(GL_SHADER_STORAGE_BUFFER, GL_READ_ONLY);
-		for(int row = 0 ; row < 8 ; row++) {
-			for(int col = 0 ; col < 8 ; col++) {
-				size_t index = row*8+col;
-				Particle::StateArrayToParticle(&vecParticles[index],
-											   aBuffer + 64*index);
-			}
+	bool HandTracker::FetchGBestReadback() {
+		// take the latest gbest the gpu is done with, usually the one
+		// queued a frame earlier
+		bool bFetched = false;
+		while(const float *aStateGBest =
+			  (const float*)m_pGBestReadback->Fetch(false)) {
+			Particle::StateArrayToParticle(
+				&m_pSwarm->GetParticleBest(), aStateGBest);
+			m_pGBestReadback->Release();
+			bFetched = true;
 		}
-		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
 
-		// download HandModelVelocity
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_idSSBOHandModelsVelocity);
-		aBuffer = (float*)glMapBuffer(GL_SHADER_STORAGE_BUFFER, GL_READ_ONLY);
-		for(int row = 0 ; row < 8 ; row++) {
-			for(int col = 0 ; col < 8 ; col++) {
-				size_t index = row*8+col;
-				memcpy(&vecParticles[index].GetVelocity()[0],
-					   aBuffer + 64*index, 64*sizeof(float));
-			}
-		}
-		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
-		
-		// download HandModelIBest
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_idSSBOHandModelsIBest);
-		aBuffer = (float*)glMapBuffer(GL_SHADER_STORAGE_BUFFER, GL_READ_ONLY);
-		for(int row = 0 ; row < 8 ; row++) {
-			for(int col = 0 ; col < 8 ; col++) {
-				size_t index = row*8+col;
-				HandModel::StateArrayToHandModel(
-					vecParticles[index].GetIBestModelLeft(),
-					aBuffer + 64*index);
-				HandModel::StateArrayToHandModel(
-					vecParticles[index].GetIBestModelRight(),
-					aBuffer + 64*index + 32);
-
-				vecParticles[index].SetIBestPenalty(aBuffer[64*index + 31]);
-			}
-		}
-		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
-		
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		return bFetched;
 	}
 	
-	void HandTracker::GenerateTransforms() {
-		glUseProgram(m_idGenerateTransformsProgram);
-   		glDispatchCompute(64, 2, 1);
-		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	void HandTracker::ResetConvergenceReadback() {
+		m_pConvergenceReadback->Reset();
 	}
-	
-	void HandTracker::ReduceDepthMaps() {
-		glUseProgram(m_idPrepareReductionTexturesProgram);
-		glDispatchCompute(320, 128, 1);
-		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 
-#ifdef PSO_TESTING
-		unsigned short *data;
-		
-		// TESTING: initialize textures with constant 1
-		data = new unsigned short[320*8*256*8];
-		for(size_t i = 0; i < 320*8*256*8; ++i) {
-			data[i] = 1;
-		}			
-		
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, m_idReductionTextures320x256[0]);
-		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 320*8, 256*8,
-						GL_RED_INTEGER, GL_UNSIGNED_SHORT, data);
-#endif
-		m_pProfiler->StartSection("Reduction");
-		
-		glUseProgram(m_idReduction1DifferenceProgram);
-		glDispatchCompute(40, 8, 1);
-		glUseProgram(m_idReduction1UnionProgram);
-		glDispatchCompute(40, 8, 1);
-		glUseProgram(m_idReduction1IntersectionProgram);
-		glDispatchCompute(40, 8, 1);	
-		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
-	
-		glUseProgram(m_idReduction2DifferenceProgram);
-		glDispatchCompute(8, 8, 1);
-		glUseProgram(m_idReduction2UnionProgram);
-		glDispatchCompute(8, 8, 1);
-		glUseProgram(m_idReduction2IntersectionProgram);
-		glDispatchCompute(8, 8, 1);
-		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
-		
-#ifdef PSO_TESTING
-		glFinish();
-#endif
-
-		m_pProfiler->StopSection();				
+	void HandTracker::QueueConvergenceReadback() {
+		m_pConvergenceReadback->CopyFrom(m_idSSBOConvergence, 0, 0,
+										 iConvergenceHeaderSize*sizeof(float));
+		m_pConvergenceReadback->Submit();
+	}
 
-#ifdef PSO_TESTING
-		glBindTexture(GL_TEXTURE_2D, m_idReductionTextures320x256[0]);
-		glGetTexImage(GL_TEXTURE_2D, 0, GL_RED_INTEGER, GL_UNSIGNED_SHORT, data);
-		vstr::err() << data[0] << std::endl;
+	bool HandTracker::GetWaitForReadbacks() {
+		// evaluation runs and configured seeds have to be repeatable,
+		// their readbacks must not depend on gpu timing
+		return m_oConfig.bEvaluate || m_oConfig.bFixedSeed;
+	}
 
-		glBindTexture(GL_TEXTURE_2D, m_idReductionTextures40x32[0]);
-		glGetTexImage(GL_TEXTURE_2D, 0, GL_RED_INTEGER, GL_UNSIGNED_SHORT, data);
-		vstr::err() << data[0] << std::endl;
+	bool HandTracker::FetchConvergenceReadback() {
+		// the oldest pending readback was queued at least one
+		// generation earlier, not being ready yet counts as not
+		// converged. repeatable runs wait for it, so the flag is
+		// always exactly one generation old.
+		const GLuint *aConvergence =
+			(const GLuint*)m_pConvergenceReadback->Fetch(
+				GetWaitForReadbacks());
+		if(!aConvergence)
+			return false;
 
-		glBindTexture(GL_TEXTURE_2D, m_idReductionTextures5x4[0]);
-		glGetTexImage(GL_TEXTURE_2D, 0, GL_RED_INTEGER, GL_UNSIGNED_SHORT, data);
-		vstr::err() << data[0] << std::endl;
+		bool bConverged = aConvergence[iConvergenceFlagOffset] != 0;
+		m_pConvergenceReadback->Release();
 
-		unsigned int *data_uint = new unsigned int[8*8];
-		glBindTexture(GL_TEXTURE_2D, m_idReductionTextures1x1[0]);
-		glGetTexImage(GL_TEXTURE_2D, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, data_uint);
-		vstr::err() << data_uint[0] << std::endl;
+		return bConverged;
+	}
+	
+	void HandTracker::GenerateTransforms() {
+		// the swarm renderer transforms in its vertex shader
+		if(m_oConfig.bStateTransforms)
+			return;
 
-		delete [] data;
-		delete [] data_uint;
-#endif
+		glUseProgram(m_idGenerateTransformsProgram);
+   		glDispatchCompute(m_oConfig.iSwarmSize, 2, 1);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	}
+	
+	void HandTracker::RenderSwarm(unsigned int iLevel) {
+		// decoupled hands are clipped to their side of the tile at
+		// the split pixel of the reduction
+		float fSplitX = 2.0f*float(m_iSplitPixel >> iLevel) /
+			float(320 >> iLevel) - 1.0f;
+		m_pSwarmRenderer->SetHandSplit(m_bDecoupledHands, fSplitX,
+									   m_bLeftHandFirst);
+
+		// FBO rendering of tiled zbuffers
+		glClear(GL_DEPTH_BUFFER_BIT);
+		m_pSwarmRenderer->PreDraw();
+		if(m_oConfig.bLayered) {
+			// the shaders pick the layer, so a single viewport and
+			// draw cover the whole swarm
+			glViewport(0, 0, 320 >> iLevel, 240 >> iLevel);
+			m_pSwarmRenderer->PerformDraw(false, 0, m_oConfig.iSwarmSize,
+										  NULL);
+		}
+		else {
+			for(size_t index = 0 ; index < m_oConfig.iSwarmSize ; index++) {
+				if( (index+1) % m_oConfig.iViewportBatch == 0 ) {
+					m_pSwarmRenderer->PerformDraw(
+						false,
+						index/m_oConfig.iViewportBatch *
+						m_oConfig.iViewportBatch,
+						m_oConfig.iViewportBatch,
+						&m_vViewportData[iLevel][0]);
+				}
+			}
+		}
+		m_pSwarmRenderer->PostDraw();
+		m_pSwarmRenderer->SetHandSplit(false);
+		glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT);
 	}
 
-	void HandTracker::UpdateSwarm(float fPhiCognitive, float fPhiSocial) {
-		// evolve particle swarm
-		glUseProgram(m_idUpdateSwarmProgram);
+	void HandTracker::ReduceDepthMaps(unsigned int iLevel) {
+		// the work groups add their sums to the cleared result
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_idSSBOReduction);
+		glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI,
+						  GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 
-		// set uniform for random SSBO offset
-		glUniform1ui(
-			m_locRandomOffsetUniform,
-			VistaRandomNumberGenerator::GetStandardRNG()->GenerateInt32());
-		
-		// set uniforms for cognitive/social behavior
-		glUniform1f(m_locPhiCognitiveUniform, fPhiCognitive);
-		glUniform1f(m_locPhiSocialUniform, fPhiSocial);
+		// all three penalty terms of every tile in a single pass, the
+		// split pixel only matters for decoupled hands
+		unsigned int iGroupsX =
+			((320 >> iLevel) + iReductionGroupWidth - 1) / iReductionGroupWidth;
+		unsigned int iGroupsY =
+			((240 >> iLevel) + iReductionGroupHeight - 1) / iReductionGroupHeight;
+
+		glUseProgram(m_idReduceDepthMapsProgram);
+		glUniform1ui(m_locReductionLevelUniform, iLevel);
+		glUniform1ui(m_locSplitPixelUniform, m_iSplitPixel >> iLevel);
+		glUniform1i(m_locInspectDifferenceUniform, m_bInspectDifference);
+		if(m_oConfig.bLayered)
+			glDispatchCompute(iGroupsX, iGroupsY, m_oConfig.iSwarmSize);
+		else
+			glDispatchCompute(iGroupsX*m_iTilesX, iGroupsY*m_iTilesY, 1);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT |
+						GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 
-		glDispatchCompute(1, 1, 1);
-		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+#ifdef PSO_TESTING
+		glFinish();
 
-		// // DEBUG: print velocities
-		// glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_idSSBOHandModelsVelocity);
-		// float *aVelocities = (float*)(glMapBuffer(GL_SHADER_STORAGE_BUFFER,
-		// 										  GL_READ_ONLY));
-		// for(int i = 0; i < 64*3; ++i) {
-		// 	vstr::out() << "velocity " << i/64 << " " << i%64 << ": "
-		// 				<< aVelocities[i] << std::endl;
-		// }
-		// glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+		std::vector<GLuint> vecResult(iReductionResultSize);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_idSSBOReduction);
+		glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0,
+						   vecResult.size()*sizeof(GLuint), &vecResult[0]);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 
-		// // DEBUG: print model state
-		// glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_idSSBOHandModels);
-		// float *aState = (float*)(glMapBuffer(GL_SHADER_STORAGE_BUFFER,
-		// 										  GL_READ_ONLY));
-		// for(int i = 0; i < 64*3; ++i) {
-		// 	vstr::out() << "state " << i/64 << " " << i%64 << ": "
-		// 				<< aState[i] << std::endl;
-		// }
-		// glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+		// side sums of the first tile
+		for(size_t i = 15; i < 21; ++i) {
+			vstr::err() << vecResult[i] << std::endl;
+		}
+#endif
 	}
 
 	float HandTracker::PenaltyNormalize(float fPenalty) {
@@ -1439,10 +2342,15 @@ namespace rhapsodies {
 		return fPenalty;
 	}
 	
-	void HandTracker::UpdateScores() {
-		// update ibest scores via compute shader 8*8
+	void HandTracker::UpdateScores(bool bResetIBest, bool bResetConvergence) {
+		// update ibest scores via compute shader, one thread per tile
 		glUseProgram(m_idUpdateScoresProgram);
-   		glDispatchCompute(1, 1, 1);
+		glUniform1i(m_locResetIBestUniform, bResetIBest);
+		glUniform1i(m_locScoresDecoupledUniform, m_bDecoupledHands);
+		glUniform1i(m_locLeftHandFirstUniform, m_bLeftHandFirst);
+		glUniform1i(m_locEvaluateOnlyUniform, false);
+   		glDispatchCompute(m_iTilesX/iScoresGroupSize,
+						  m_iTilesY/iScoresGroupSize, 1);
 		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
 
 		// // DEBUG: print all particle scores
@@ -1455,11 +2363,26 @@ namespace rhapsodies {
 		// }
 		// glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
 
-		// find gbest particle
+		// find gbest particle and track convergence
 		glUseProgram(m_idUpdateGBestProgram);
+		glUniform1i(m_locResetConvergenceUniform, bResetConvergence);
+		glUniform1f(m_locConvergenceEpsilonUniform,
+					m_oConfig.fConvergenceEpsilon);
+		glUniform1f(m_locConvergenceSpreadUniform,
+					m_oConfig.fConvergenceSpread);
+		glUniform1ui(m_locConvergencePlateauUniform,
+					 m_oConfig.iConvergencePlateau);
+		glUniform1i(m_locGBestDecoupledUniform, m_bDecoupledHands);
    		glDispatchCompute(1, 1, 1);
 		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
 
+		// ring neighbors per hand block, update_swarm.comp is
+		// dispatched by OptimizerParticleSwarm::Step()
+		if(m_idUpdateSwarmProgram) {
+			glUseProgram(m_idUpdateSwarmProgram);
+			glUniform1i(m_locSwarmDecoupledUniform, m_bDecoupledHands);
+		}
+
 		// // DEBUG: print gbest particle score
 		// glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_idSSBOHandModelsGBest);
 		// float *aStateGBest = (float*)(glMapBuffer(GL_SHADER_STORAGE_BUFFER,
@@ -1469,18 +2392,58 @@ namespace rhapsodies {
 		// glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
 	}
 
-	void HandTracker::UpdateOutputModel() {
-		// get best match from gbest buffer
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_idSSBOHandModelsGBest);
-		float *aStateGBest = (float*)(glMapBuffer(GL_SHADER_STORAGE_BUFFER,
-												  GL_READ_ONLY));	
+	void HandTracker::PrepareFusedStep(bool bResetIBest,
+									   bool bResetConvergence) {
+		// pso_step.comp scores, finds gbest and updates the swarm in
+		// the dispatch of OptimizerParticleSwarm::Step()
+		glUseProgram(m_idPSOStepProgram);
+		glUniform1i(m_locStepResetIBestUniform, bResetIBest);
+		glUniform1i(m_locStepDecoupledUniform, m_bDecoupledHands);
+		glUniform1i(m_locStepLeftHandFirstUniform, m_bLeftHandFirst);
+		glUniform1i(m_locStepResetConvergenceUniform, bResetConvergence);
+		glUniform1f(m_locStepConvergenceEpsilonUniform,
+					m_oConfig.fConvergenceEpsilon);
+		glUniform1f(m_locStepConvergenceSpreadUniform,
+					m_oConfig.fConvergenceSpread);
+		glUniform1ui(m_locStepConvergencePlateauUniform,
+					 m_oConfig.iConvergencePlateau);
+	}
 
-		Particle::StateArrayToParticle(
-			&m_pSwarm->GetParticleBest(), aStateGBest);
+	void HandTracker::RefineGBest(unsigned int iLevel,
+								  unsigned int iGeneration) {
+		// each step scores a finite difference batch and a batch of
+		// damped steps on the last resolution level of the swarm.
+		// both count as generations in the evaluation output.
+		for(unsigned int step = 0; step < m_oConfig.iRefineSteps; ++step) {
+			m_pRefinement->PrepareJacobian(step == 0);
+			EvaluateRefinementBatch(iLevel);
+			if(m_oConfig.bEvaluate)
+				EvaluationStep(iGeneration++);
 
-		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+			m_pRefinement->PrepareSteps();
+			EvaluateRefinementBatch(iLevel);
+			m_pRefinement->AcceptStep();
+			if(m_oConfig.bEvaluate)
+				EvaluationStep(iGeneration++);
+		}
+	}
+
+	void HandTracker::EvaluateRefinementBatch(unsigned int iLevel) {
+		GenerateTransforms();
+		RenderSwarm(iLevel);
+		ReduceDepthMaps(iLevel);
+
+		// joint penalties only, ibest and gbest are left alone
+		glUseProgram(m_idUpdateScoresProgram);
+		glUniform1i(m_locResetIBestUniform, false);
+		glUniform1i(m_locScoresDecoupledUniform, false);
+		glUniform1i(m_locEvaluateOnlyUniform, true);
+   		glDispatchCompute(m_iTilesX/iScoresGroupSize,
+						  m_iTilesY/iScoresGroupSize, 1);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	}
 
+	void HandTracker::SmoothOutputModel() {
 		// do exponential smoothing on the output model
 		SmoothInterpolateModel(
 			m_oConfig.fSmoothingFactor,
@@ -1496,9 +2459,9 @@ namespace rhapsodies {
 		float fSmoothingFactor,
 		HandModel *pModelNew,
 		HandModel *pModelAccumulated) {
-		std::vector<float> &vecAnglesNew =
+		HandModel::JointAngleArray &vecAnglesNew =
 			pModelNew->GetJointAngles();
-		std::vector<float> &vecAnglesAccumulated =
+		HandModel::JointAngleArray &vecAnglesAccumulated =
 			pModelAccumulated->GetJointAngles();
 
 		for(size_t i = 0; i < vecAnglesNew.size(); ++i) {
@@ -1516,22 +2479,57 @@ namespace rhapsodies {
 				pModelNew->GetOrientation(), fSmoothingFactor));
 	}
 
-	void HandTracker::EvaluationStep() {
-		// write out HandModel scores
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_idSSBOHandModels);
-		float *aBuffer =
-			(float*)glMapBuffer(GL_SHADER_STORAGE_BUFFER, GL_READ_ONLY);
-		for(int row = 0 ; row < 8 ; row++) {
-			for(int col = 0 ; col < 8 ; col++) {
-				size_t index = row*8+col;
-				m_osEvalOutput << aBuffer[64*index + 31];
+	void HandTracker::EvaluationStep(unsigned int iGeneration) {
+		// write out what the gpu is done with. the ring only runs full
+		// if the gpu lags more than two frames behind.
+		WriteEvaluationResults(false);
+		if(m_pEvaluationReadback->GetIsFull()) {
+			vstr::warn() << "Evaluation readback ring full, waiting."
+						 << std::endl;
+			WriteEvaluationResults(true);
+		}
+
+		// HandModel states followed by gbest
+		size_t iBufferSize = m_oConfig.iSwarmSize*iStateSize*sizeof(float);
+		m_pEvaluationReadback->CopyFrom(m_idSSBOHandModels, 0, 0, iBufferSize);
+		m_pEvaluationReadback->CopyFrom(m_idSSBOHandModelsGBest, 0,
+										iBufferSize, iStateSize*sizeof(float));
+		m_pEvaluationReadback->Submit();
+
+		m_deqEvaluationPending.push_back(
+			std::make_pair(m_iRandomFrame, iGeneration));
+	}
+
+	void HandTracker::WriteEvaluationResults(bool bWait) {
+		while(const float *aBuffer =
+			  (const float*)m_pEvaluationReadback->Fetch(bWait)) {
+			unsigned int iFrame      = m_deqEvaluationPending.front().first;
+			unsigned int iGeneration = m_deqEvaluationPending.front().second;
+			m_deqEvaluationPending.pop_front();
+
+			// HandModel scores
+			for(size_t index = 0 ; index < m_oConfig.iSwarmSize ; index++) {
+				m_osEvalOutput << aBuffer[iStateSize*index +
+										  HandStateLayout::iPenaltyOffset];
 			}
+
+			// gbest penalty after this many rendered candidates
+			const float *aGBest = aBuffer + m_oConfig.iSwarmSize*iStateSize;
+			m_osBenchOutput << iFrame << " " << iGeneration << " "
+							<< (iGeneration+1)*m_oConfig.iSwarmSize << " "
+							<< aGBest[HandStateLayout::iPenaltyOffset]
+							<< std::endl;
+
+			m_pEvaluationReadback->Release();
 		}
-		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 	}
 
 	void HandTracker::EvaluationPostFrame() {
+		// results still in flight are written before the output
+		// files change
+		if(m_pEvaluationReadback)
+			WriteEvaluationResults(m_pFramePlayer->GetIsStopped());
+
 		if(m_pFramePlayer->GetIsStopped()) {
 			if(++m_iEvalIteration < m_oConfig.iIterations) {
 				m_pFramePlayer->StartPlayback();
@@ -1545,7 +2543,10 @@ namespace rhapsodies {
 				}
 				else {
 					m_osEvalOutput.close();
+					m_osBenchOutput.close();
 					m_oConfig.bEvaluate = false;
+
+					m_pGpuProfiler->PrintReport(vstr::out());
 				}
 			}
 		}
@@ -1571,6 +2572,12 @@ namespace rhapsodies {
 
 	void HandTracker::StartTracking() {
 		m_bTrackingEnabled = true;
+		m_bSwarmUploadPending = true;
+		m_pSwarm->ResetMotion();
+		m_iRandomFrame = 0;
+
+		// start pose penalties still in flight are stale afterwards
+		m_pStartPoseReadback->Reset();
 
 		WriteDebug(IDebugView::TRACKING,
 				   IDebugView::FormatString("Tracking: ",
@@ -1580,6 +2587,13 @@ namespace rhapsodies {
 	void HandTracker::StopTracking() {
 		m_bTrackingEnabled = false;
 
+		m_pGpuProfiler->PrintReport(vstr::out());
+
+		// drop readbacks still in flight
+		m_pGBestReadback->Reset();
+		ResetConvergenceReadback();
+		m_bDecoupledHands = false;
+
 		SetToInitialPose(m_pSwarm->GetParticleBest());
 		*m_pHandModelLeft  = *m_pSwarm->GetParticleBest().GetHandModelLeft();
 		*m_pHandModelRight = *m_pSwarm->GetParticleBest().GetHandModelRight();
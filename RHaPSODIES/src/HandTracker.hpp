@@ -25,11 +25,13 @@
 #define _RHAPSODIES_HANDTRACKER
 
 #include <map>
+#include <deque>
 #include <fstream>
 
 #include <VistaAspects/VistaPropertyList.h>
 
 #include "DebugView.hpp"
+#include "ShaderRegistry.hpp"
 
 class VistaRandomNumberGenerator;
 class VistaBasicProfiler;
@@ -45,6 +47,10 @@ namespace rhapsodies {
 
 	class Particle;
 	class ParticleSwarm;
+	class Optimizer;
+	class LevenbergMarquardt;
+	class GpuProfiler;
+	class TransferRing;
 
 	class CameraFrameRecorder;
 	class CameraFramePlayer;
@@ -68,11 +74,30 @@ namespace rhapsodies {
 		HandModel *GetHandModelRight();
 		HandGeometry *GetHandGeometry();
 
+		/**
+		 * The rendered depth tiles as one 2D atlas texture. With
+		 * TARGET = LAYERED the tiles are layers of an array texture
+		 * instead and this is a 2D view of layer 0 only, i.e. the
+		 * tile of the first particle; the debug views show no other
+		 * particles then.
+		 */
 		GLuint GetRenderedTextureId();
 		GLuint GetCameraTextureId();
 
 		GLuint GetResultTextureId();
+		/**
+		 * 0 until difference inspection is first switched on.
+		 */
 		GLuint GetDifferenceTextureId();
+
+		/**
+		 * Writes the per pixel depth difference of each tile to the
+		 * difference texture, which is created on the first call
+		 * with bInspect set. Off by default, the reduction then
+		 * fetches camera depth only where a hand was rendered.
+		 */
+		void SetInspectDifference(bool bInspect);
+		bool GetInspectDifference();
 		GLuint GetUnionTextureId();
 		GLuint GetIntersectionTextureId();
 		
@@ -119,19 +144,64 @@ namespace rhapsodies {
 			float fSmoothingFactor;
 			
 			unsigned int iViewportBatch;
+			bool bImpostors; // ray cast quads instead of meshes
+			bool bStateTransforms; // swarm transforms in the vertex shader
+			bool bLayered; // one texture array layer per particle
 
+			unsigned int iSwarmSize;    // number of particles
 			unsigned int iPSOGenerations;
 			float fPhiCognitiveBegin;
 			float fPhiCognitiveEnd;
 			unsigned int iKeepKBest;
+			bool bGpuSwarmInit;
+
+			// depth pyramid level per block of generations, level l
+			// evaluates tiles of (320x240)/2^l
+			std::vector<int> vecResolutionSchedule;
+
+			// early termination once gbest and the swarm stop
+			// changing for iConvergencePlateau generations (0: off)
+			unsigned int iConvergencePlateau;
+			float fConvergenceEpsilon; // relative gbest improvement
+			float fConvergenceSpread;  // rms joint distance in degrees
+			bool bDecoupleHands;
+			unsigned int iDecoupleMinGap; // screen space gap in pixels
+			float fMotionDamping; // share of predicted motion per frame
+			float fMotionSpread;  // extra spread per unit of motion
+			unsigned int iRandomSeed; // philox key, fixed for repeatable runs
+			bool bFixedSeed;          // RANDOM_SEED is configured
+			bool bHaltonSpread;       // scrambled halton instead of random
+			std::string sOptimizer;   // PSO or CMAES
+			bool bRingTopology;
+			bool bFusedStep; // scores, gbest and PSO update in one dispatch
+			float fInertiaBegin;
+			float fInertiaEnd;
+			float fCMAESSigma;        // initial step size
+
+			// levenberg-marquardt steps on gbest after the swarm
+			// generations (0: off)
+			unsigned int iRefineSteps;
+			float fRefineDifferenceStep; // in units of the seeding spread
+			float fRefineDamping;        // initial relative damping
+
+			// objective and joint limits, compiled into the shaders
+			float fDepthMargin; // depth difference clamp in m
+			float fLambda;      // weight of the depth term
+			float fLambdaK;     // weight of the pose prior
+			std::vector<float> vecJointLimits; // min, max per limit group
 		};
 
 		bool HasGLComputeCapabilities();
 
+		bool InitPrograms();
+		GLuint GetSpecializedProgram(const std::string &sName);
+		GLuint GetSwarmProgram();
+		GLenum GetRenderedTextureTarget();
 		bool InitFrameFilter();
 		bool InitRendering();
 		bool InitGpuPSO();
 		bool InitReduction();
+		bool InitDifferenceTexture();
 		bool InitParticleSwarm();
 		bool InitOutputModel();
 		bool InitEvaluation();
@@ -141,7 +211,8 @@ namespace rhapsodies {
 		void PerformStartPoseMatch();
 
 		void PrepareEvaluationFiles();
-		void EvaluationStep();
+		void EvaluationStep(unsigned int iGeneration);
+		void WriteEvaluationResults(bool bWait);
 		void EvaluationPostFrame();
 		
 		void FrameRecordingAndPlayback(
@@ -153,18 +224,33 @@ namespace rhapsodies {
 		void ResourcesUnbind();
 		
 		void UploadCameraDepthMap();
+		unsigned int GetResolutionLevel(unsigned int iGeneration);
+		void UpdateHandSeparation();
 		void SetupProjection();
 
 		void UploadHandModels();
 		void DownloadHandModels();
+
+		void InitializeSwarmGpu(bool bResetMotion);
+		void QueueGBestReadback();
+		bool FetchGBestReadback();
+
+		void ResetConvergenceReadback();
+		void QueueConvergenceReadback();
+		bool FetchConvergenceReadback();
+		bool GetWaitForReadbacks();
 		
 		void GenerateTransforms();
 
-		void ReduceDepthMaps();
-		void UpdateScores();
-		void UpdateSwarm(float fPhiCognitive, float fPhiSocial);
+		void RenderSwarm(unsigned int iLevel);
+		void ReduceDepthMaps(unsigned int iLevel);
+		void UpdateScores(bool bResetIBest, bool bResetConvergence);
+		void PrepareFusedStep(bool bResetIBest, bool bResetConvergence);
 
-		void UpdateOutputModel();
+		void RefineGBest(unsigned int iLevel, unsigned int iGeneration);
+		void EvaluateRefinementBatch(unsigned int iLevel);
+
+		void SmoothOutputModel();
 		void SmoothInterpolateModel(float fSmoothingFactor,
 									HandModel *pModelNew,
 									HandModel *pModelOld);
@@ -183,61 +269,116 @@ namespace rhapsodies {
 		
 		HandGeometry *m_pHandGeometry;
 		HandRenderer *m_pHandRenderer;
+		// draws the swarm tiles, m_pHandRenderer unless the
+		// transforms come from the particle state
+		HandRenderer *m_pSwarmRenderer;
 
 		unsigned char  *m_pColorBuffer;
 		unsigned short *m_pDepthBuffer;
 		float          *m_pUVMapBuffer;
 
-		std::vector<float> m_vViewportData;
+		// particle tiles are laid out in an atlas of
+		// m_iTilesX*m_iTilesY tiles of 320x240 each
+		unsigned int m_iTilesX;
+		unsigned int m_iTilesY;
+
+		// viewport data per depth pyramid level, the camera depth
+		// texture holds one mipmap per level
+		unsigned int m_iResolutionLevels;
+		std::vector<std::vector<float> > m_vViewportData;
 
 		IDebugView *m_pDebugView;
 
+		// an atlas of m_iTilesX*m_iTilesY tiles or, with
+		// bLayered, a 2D array of one tile per layer. the view shows
+		// the first layer as 2D texture for inspection.
 		GLuint m_idRenderedTexture;
 		GLuint m_idRenderedTextureFBO;
+		GLuint m_idRenderedTextureView;
 
 		GLuint m_idCameraTexture;		
-		GLuint m_idCameraTexturePBO;
 
-		GLuint m_idGenerateTransformsProgram;
+		// compile time constants of all compute programs, derived
+		// from the configuration in InitPrograms()
+		ShaderRegistry::Defines m_mapShaderDefines;
 
-		GLuint m_idPrepareReductionTexturesProgram;
+		GLuint m_idGenerateTransformsProgram;
 
-		GLuint m_idReduction0DifferenceProgram;
-		GLuint m_idReduction1DifferenceProgram;
-		GLuint m_idReduction2DifferenceProgram;
-		GLuint m_idReduction0UnionProgram;
-		GLuint m_idReduction1UnionProgram;
-		GLuint m_idReduction2UnionProgram;
-		GLuint m_idReduction0IntersectionProgram;
-		GLuint m_idReduction1IntersectionProgram;
-		GLuint m_idReduction2IntersectionProgram;
+		GLuint m_idReduceDepthMapsProgram;
+		GLint m_locReductionLevelUniform;
+		GLint m_locSplitPixelUniform;
+		GLint m_locInspectDifferenceUniform;
 
 		GLuint m_idUpdateScoresProgram;
+		GLint m_locResetIBestUniform;
+		GLint m_locScoresDecoupledUniform;
+		GLint m_locLeftHandFirstUniform;
+		GLint m_locEvaluateOnlyUniform;
 		GLuint m_idUpdateGBestProgram;
+		GLint m_locResetConvergenceUniform;
+		GLint m_locConvergenceEpsilonUniform;
+		GLint m_locConvergenceSpreadUniform;
+		GLint m_locConvergencePlateauUniform;
+		GLint m_locGBestDecoupledUniform;
+
+		// pso_step.comp, only the score and gbest uniforms. the PSO
+		// optimizer sets the rest and dispatches it.
+		GLuint m_idPSOStepProgram;
+		GLint m_locStepResetIBestUniform;
+		GLint m_locStepDecoupledUniform;
+		GLint m_locStepLeftHandFirstUniform;
+		GLint m_locStepResetConvergenceUniform;
+		GLint m_locStepConvergenceEpsilonUniform;
+		GLint m_locStepConvergenceSpreadUniform;
+		GLint m_locStepConvergencePlateauUniform;
+
+		// update_swarm.comp, only the hand decoupling. the PSO
+		// optimizer sets the rest and dispatches it.
 		GLuint m_idUpdateSwarmProgram;
-		GLint m_locPhiCognitiveUniform;
-		GLint m_locPhiSocialUniform;
-
+		GLint m_locSwarmDecoupledUniform;
+
+		GLuint m_idInitializeSwarmProgram;
+		GLint m_locInitRandomSeedUniform;
+		GLint m_locInitRandomFrameUniform;
+		GLint m_locKeepKBestUniform;
+		GLint m_locResetMotionUniform;
+		GLint m_locMotionDampingUniform;
+		GLint m_locMotionSpreadUniform;
+		GLint m_locHaltonUniform;
+		GLint m_locInitDecoupledUniform;
+
+		// the difference texture is only written once it is asked for
 		GLuint m_idDifferenceTexture;
-
-		enum TextureIndex {
-			DIFFERENCE,
-			UNION,
-			INTERSECTION
-		};
-		
-		GLuint m_idReductionTextures320x256[3];
-		GLuint m_idReductionTextures40x32[3];
-		GLuint m_idReductionTextures5x4[3];
-		GLuint m_idReductionTextures1x1[3];
+		bool m_bInspectDifference;
 
 		GLuint m_idSSBOHandModels;
 		GLuint m_idSSBOHandModelsIBest;
 		GLuint m_idSSBOHandModelsGBest;
 		GLuint m_idSSBOHandModelsVelocity;
 		GLuint m_idSSBOHandGeometry;
-		GLuint m_idSSBORandom;
 		GLuint m_idSSBODebug;
+		GLuint m_idSSBOConvergence;
+		GLuint m_idSSBOMotion;
+		GLuint m_idSSBOReduction;
+		GLuint m_idSSBOCamera;
+
+		// all cpu<->gpu transfers are staged through fenced rings,
+		// see TransferRing
+		TransferRing *m_pCameraUpload;
+		TransferRing *m_pSwarmUpload;
+		TransferRing *m_pSwarmReadback;
+		TransferRing *m_pStartPoseReadback;
+
+		// asynchronous gbest readback, fetched one frame behind
+		TransferRing *m_pGBestReadback;
+
+		// convergence flag readback, checked one generation behind
+		TransferRing *m_pConvergenceReadback;
+
+		// swarm penalties per generation, written out once the gpu
+		// is done. frame and generation of each pending readback.
+		TransferRing *m_pEvaluationReadback;
+		std::deque<std::pair<unsigned int, unsigned int> > m_deqEvaluationPending;
 		
 		GLint  m_locColorUniform;
 		GLuint m_idColorFragProgram;
@@ -250,17 +391,31 @@ namespace rhapsodies {
 		CameraFrameFilter *m_pFrameFilter;
 
 		std::ofstream m_osEvalOutput;
+		std::ofstream m_osBenchOutput;
 		std::vector<std::string>::const_iterator m_itCurPlayback;
 		unsigned int m_iEvalIteration;
 		
 		bool m_bTrackingEnabled;
+		bool m_bSwarmUploadPending;
+
+		// hands far enough apart on screen are optimized as two
+		// independent sub-swarms, each rendered and scored on its
+		// side of the split pixel column
+		bool m_bDecoupledHands;
+		bool m_bLeftHandFirst;
+		unsigned int m_iSplitPixel;
 		ParticleSwarm *m_pSwarm;
+		Optimizer *m_pOptimizer;
+		LevenbergMarquardt *m_pRefinement;
+		GpuProfiler *m_pGpuProfiler;
 
 		HandModel *m_pHandModelLeft;
 		HandModel *m_pHandModelRight;
 
 		VistaRandomNumberGenerator *m_pRNG;
-		GLint m_locRandomOffsetUniform;
+
+		// frame counter of the philox streams, restarts with tracking
+		unsigned int m_iRandomFrame;
 
 		VistaBasicProfiler *m_pProfiler;
 	};
@@ -0,0 +1,90 @@
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "../HandStateLayout.hpp"
+#include "LevenbergMarquardt.hpp"
+
+namespace {
+	// binding of the refinement state in refine_*.comp
+	const int iSSBOStateLocation = 10;
+
+	// penalty, damping, padding and current pose
+	const size_t iStateHeaderSize = 4;
+	const size_t iStateSize = iStateHeaderSize +
+		rhapsodies::HandStateLayout::iParticleStride;
+}
+
+namespace rhapsodies {
+	LevenbergMarquardt::LevenbergMarquardt(GLuint idJacobianProgram,
+										   GLuint idSolveProgram,
+										   GLuint idAcceptProgram,
+										   float fDifferenceStep,
+										   float fDampingInitial) :
+		m_idJacobianProgram(idJacobianProgram),
+		m_idSolveProgram(idSolveProgram),
+		m_idAcceptProgram(idAcceptProgram),
+		m_fDifferenceStep(fDifferenceStep),
+		m_fDampingInitial(fDampingInitial) {
+
+		m_locStartUniform =
+			glGetUniformLocation(m_idJacobianProgram, "bStart");
+		m_locDampingInitialUniform =
+			glGetUniformLocation(m_idJacobianProgram, "fDampingInitial");
+		m_locJacobianDifferenceStepUniform =
+			glGetUniformLocation(m_idJacobianProgram, "fDifferenceStep");
+
+		m_locSolveDifferenceStepUniform =
+			glGetUniformLocation(m_idSolveProgram, "fDifferenceStep");
+
+		// started from gbest on the first step of each frame
+		std::vector<float> vecState(iStateSize, 0.0f);
+		glGenBuffers(1, &m_idSSBOState);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_idSSBOState);
+		glBufferData(GL_SHADER_STORAGE_BUFFER,
+					 vecState.size()*sizeof(float),
+					 &vecState[0], GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+
+	LevenbergMarquardt::~LevenbergMarquardt() {
+		glDeleteBuffers(1, &m_idSSBOState);
+	}
+
+	void LevenbergMarquardt::PrepareJacobian(bool bStart) {
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER,
+						 iSSBOStateLocation, m_idSSBOState);
+
+		glUseProgram(m_idJacobianProgram);
+		glUniform1i(m_locStartUniform, bStart);
+		glUniform1f(m_locDampingInitialUniform, m_fDampingInitial);
+		glUniform1f(m_locJacobianDifferenceStepUniform, m_fDifferenceStep);
+		glDispatchCompute(1, 1, 1);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, iSSBOStateLocation, 0);
+	}
+
+	void LevenbergMarquardt::PrepareSteps() {
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER,
+						 iSSBOStateLocation, m_idSSBOState);
+
+		glUseProgram(m_idSolveProgram);
+		glUniform1f(m_locSolveDifferenceStepUniform, m_fDifferenceStep);
+		glDispatchCompute(1, 1, 1);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, iSSBOStateLocation, 0);
+	}
+
+	void LevenbergMarquardt::AcceptStep() {
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER,
+						 iSSBOStateLocation, m_idSSBOState);
+
+		glUseProgram(m_idAcceptProgram);
+		glDispatchCompute(1, 1, 1);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, iSSBOStateLocation, 0);
+	}
+}
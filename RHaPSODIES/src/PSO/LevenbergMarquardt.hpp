@@ -0,0 +1,60 @@
+#ifndef _RHAPSODIES_LEVENBERGMARQUARDT
+#define _RHAPSODIES_LEVENBERGMARQUARDT
+
+#include <GL/gl.h>
+
+namespace rhapsodies {
+	/**
+	 * Levenberg-Marquardt refinement of gbest after the swarm
+	 * generations. Each step takes two scored batches of the tile
+	 * atlas: refine_jacobian.comp writes the current pose and one
+	 * forward difference per degree of freedom, refine_solve.comp
+	 * turns their residuals into a ladder of damped steps, one per
+	 * tile, and refine_accept.comp keeps the best of them. Scoring
+	 * is left to the HandTracker, the swarm needs more tiles than
+	 * HandStateLayout::iDofCount.
+	 */
+	class LevenbergMarquardt {
+	public:
+		LevenbergMarquardt(GLuint idJacobianProgram,
+						   GLuint idSolveProgram,
+						   GLuint idAcceptProgram,
+						   float fDifferenceStep,
+						   float fDampingInitial);
+		~LevenbergMarquardt();
+
+		/**
+		 * Writes the finite difference batch, the first step of a
+		 * frame starts from gbest.
+		 */
+		void PrepareJacobian(bool bStart);
+
+		/**
+		 * Writes the damping ladder from the scored finite
+		 * difference batch.
+		 */
+		void PrepareSteps();
+
+		/**
+		 * Takes the best scored step into gbest if it improves.
+		 */
+		void AcceptStep();
+
+	private:
+		GLuint m_idJacobianProgram;
+		GLuint m_idSolveProgram;
+		GLuint m_idAcceptProgram;
+		float m_fDifferenceStep;
+		float m_fDampingInitial;
+
+		// current pose, its penalty and damping
+		GLuint m_idSSBOState;
+
+		GLint m_locStartUniform;
+		GLint m_locDampingInitialUniform;
+		GLint m_locJacobianDifferenceStepUniform;
+		GLint m_locSolveDifferenceStepUniform;
+	};
+}
+
+#endif // _RHAPSODIES_LEVENBERGMARQUARDT
@@ -0,0 +1,30 @@
+#ifndef _RHAPSODIES_OPTIMIZER
+#define _RHAPSODIES_OPTIMIZER
+
+#include <string>
+
+namespace rhapsodies {
+	/**
+	 * Proposes candidate batches for the tiled render-and-reduce
+	 * evaluation. Each generation, update_scores.comp and
+	 * update_gbest.comp write the penalties of the evaluated batch
+	 * to the hand model SSBOs, Step() consumes them and writes the
+	 * next batch to the hand model SSBO in place. The fused PSO
+	 * step does all of this in Step(). All SSBOs are bound by the
+	 * HandTracker.
+	 */
+	class Optimizer {
+	public:
+		virtual ~Optimizer() {};
+
+		virtual std::string GetName()=0;
+
+		/**
+		 * iGeneration counts from 0 within each frame, the first
+		 * batch of a frame comes from the swarm initialization.
+		 */
+		virtual void Step(unsigned int iFrame, unsigned int iGeneration)=0;
+	};
+}
+
+#endif // _RHAPSODIES_OPTIMIZER
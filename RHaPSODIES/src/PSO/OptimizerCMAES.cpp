@@ -0,0 +1,88 @@
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "../HandStateLayout.hpp"
+#include "OptimizerCMAES.hpp"
+
+namespace {
+	// binding of the distribution state in cmaes_*.comp
+	const int iSSBOStateLocation = 7;
+
+	// local work group size of cmaes_sample.comp
+	const unsigned int iSampleGroupSize = 16;
+
+	// step size, mean, evolution paths and covariance
+	const size_t iStateHeaderSize = 4;
+	const size_t iStateSize = iStateHeaderSize +
+		4*rhapsodies::HandStateLayout::iParticleStride;
+}
+
+namespace rhapsodies {
+	OptimizerCMAES::OptimizerCMAES(GLuint idUpdateProgram,
+								   GLuint idSampleProgram,
+								   unsigned int iSwarmSize,
+								   float fSigmaInitial,
+								   unsigned int iRandomSeed) :
+		m_idUpdateProgram(idUpdateProgram),
+		m_idSampleProgram(idSampleProgram),
+		m_iSwarmSize(iSwarmSize),
+		m_fSigmaInitial(fSigmaInitial),
+		m_iRandomSeed(iRandomSeed) {
+
+		m_locResetUniform =
+			glGetUniformLocation(m_idUpdateProgram, "bReset");
+		m_locSigmaInitialUniform =
+			glGetUniformLocation(m_idUpdateProgram, "fSigmaInitial");
+		m_locGenerationUniform =
+			glGetUniformLocation(m_idUpdateProgram, "iGeneration");
+
+		m_locRandomSeedUniform =
+			glGetUniformLocation(m_idSampleProgram, "iRandomSeed");
+		m_locRandomFrameUniform =
+			glGetUniformLocation(m_idSampleProgram, "iRandomFrame");
+		m_locRandomGenerationUniform =
+			glGetUniformLocation(m_idSampleProgram, "iRandomGeneration");
+
+		// restarted on the first step of each frame, zero is fine
+		std::vector<float> vecState(iStateSize, 0.0f);
+		glGenBuffers(1, &m_idSSBOState);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_idSSBOState);
+		glBufferData(GL_SHADER_STORAGE_BUFFER,
+					 vecState.size()*sizeof(float),
+					 &vecState[0], GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+
+	OptimizerCMAES::~OptimizerCMAES() {
+		glDeleteBuffers(1, &m_idSSBOState);
+	}
+
+	std::string OptimizerCMAES::GetName() {
+		return "CMA-ES";
+	}
+
+	void OptimizerCMAES::Step(unsigned int iFrame,
+							  unsigned int iGeneration) {
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER,
+						 iSSBOStateLocation, m_idSSBOState);
+
+		// adapt the distribution to the ranked batch
+		glUseProgram(m_idUpdateProgram);
+		glUniform1i(m_locResetUniform, iGeneration == 0);
+		glUniform1f(m_locSigmaInitialUniform, m_fSigmaInitial);
+		glUniform1ui(m_locGenerationUniform, iGeneration);
+		glDispatchCompute(1, 1, 1);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+		// draw the next batch
+		glUseProgram(m_idSampleProgram);
+		glUniform1ui(m_locRandomSeedUniform, m_iRandomSeed);
+		glUniform1ui(m_locRandomFrameUniform, iFrame);
+		glUniform1ui(m_locRandomGenerationUniform, iGeneration);
+		glDispatchCompute(m_iSwarmSize/iSampleGroupSize, 1, 1);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, iSSBOStateLocation, 0);
+	}
+}
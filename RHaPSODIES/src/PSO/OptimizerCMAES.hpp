@@ -0,0 +1,47 @@
+#ifndef _RHAPSODIES_OPTIMIZERCMAES
+#define _RHAPSODIES_OPTIMIZERCMAES
+
+#include <GL/gl.h>
+
+#include "Optimizer.hpp"
+
+namespace rhapsodies {
+	/**
+	 * Separable CMA-ES (diagonal covariance) with the swarm size as
+	 * population. cmaes_update.comp adapts the distribution from the
+	 * ranked batch, cmaes_sample.comp draws the next batch. The
+	 * distribution is restarted from the initialized swarm on the
+	 * first generation of every frame.
+	 */
+	class OptimizerCMAES : public Optimizer {
+	public:
+		OptimizerCMAES(GLuint idUpdateProgram,
+					   GLuint idSampleProgram,
+					   unsigned int iSwarmSize,
+					   float fSigmaInitial,
+					   unsigned int iRandomSeed);
+		~OptimizerCMAES();
+
+		std::string GetName();
+		void Step(unsigned int iFrame, unsigned int iGeneration);
+
+	private:
+		GLuint m_idUpdateProgram;
+		GLuint m_idSampleProgram;
+		unsigned int m_iSwarmSize;
+		float m_fSigmaInitial;
+		unsigned int m_iRandomSeed;
+
+		// mean, evolution paths and diagonal covariance
+		GLuint m_idSSBOState;
+
+		GLint m_locResetUniform;
+		GLint m_locSigmaInitialUniform;
+		GLint m_locGenerationUniform;
+		GLint m_locRandomSeedUniform;
+		GLint m_locRandomFrameUniform;
+		GLint m_locRandomGenerationUniform;
+	};
+}
+
+#endif // _RHAPSODIES_OPTIMIZERCMAES
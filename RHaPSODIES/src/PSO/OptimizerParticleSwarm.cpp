@@ -0,0 +1,70 @@
+#include <GL/glew.h>
+
+#include "OptimizerParticleSwarm.hpp"
+
+namespace {
+	// local work group size of update_swarm.comp
+	const unsigned int iSwarmGroupSize = 16;
+}
+
+namespace rhapsodies {
+	OptimizerParticleSwarm::OptimizerParticleSwarm(
+		GLuint idProgram, const Parameters &oParams) :
+		m_idProgram(idProgram),
+		m_oParams(oParams) {
+
+		m_locPhiCognitiveUniform =
+			glGetUniformLocation(m_idProgram, "fPhiCognitive");
+		m_locPhiSocialUniform =
+			glGetUniformLocation(m_idProgram, "fPhiSocial");
+		m_locInertiaUniform =
+			glGetUniformLocation(m_idProgram, "fInertia");
+		m_locRingTopologyUniform =
+			glGetUniformLocation(m_idProgram, "bRingTopology");
+		m_locRandomSeedUniform =
+			glGetUniformLocation(m_idProgram, "iRandomSeed");
+		m_locRandomFrameUniform =
+			glGetUniformLocation(m_idProgram, "iRandomFrame");
+		m_locRandomGenerationUniform =
+			glGetUniformLocation(m_idProgram, "iRandomGeneration");
+	}
+
+	std::string OptimizerParticleSwarm::GetName() {
+		return m_oParams.bRingTopology ? "PSO (ring)" : "PSO";
+	}
+
+	void OptimizerParticleSwarm::Step(unsigned int iFrame,
+									  unsigned int iGeneration) {
+		float fProgress = 0.0f;
+		if(m_oParams.iGenerations > 1)
+			fProgress = float(iGeneration)/float(m_oParams.iGenerations-1);
+
+		float fPhiCognitive = m_oParams.fPhiCognitiveBegin + fProgress *
+			(m_oParams.fPhiCognitiveEnd - m_oParams.fPhiCognitiveBegin);
+		float fPhiSocial = 4.1f - fPhiCognitive;
+		float fInertia = m_oParams.fInertiaBegin + fProgress *
+			(m_oParams.fInertiaEnd - m_oParams.fInertiaBegin);
+
+		// evolve particle swarm
+		glUseProgram(m_idProgram);
+
+		// philox counters, see philox.part
+		glUniform1ui(m_locRandomSeedUniform, m_oParams.iRandomSeed);
+		glUniform1ui(m_locRandomFrameUniform, iFrame);
+		glUniform1ui(m_locRandomGenerationUniform, iGeneration);
+		
+		// set uniforms for cognitive/social behavior
+		glUniform1f(m_locPhiCognitiveUniform, fPhiCognitive);
+		glUniform1f(m_locPhiSocialUniform, fPhiSocial);
+		glUniform1f(m_locInertiaUniform, fInertia);
+		glUniform1i(m_locRingTopologyUniform, m_oParams.bRingTopology);
+
+		// the fused step synchronizes the whole swarm in shared
+		// memory, so it is one work group
+		if(m_oParams.bFused)
+			glDispatchCompute(1, 1, 1);
+		else
+			glDispatchCompute(m_oParams.iSwarmSize/iSwarmGroupSize, 1, 1);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	}
+}
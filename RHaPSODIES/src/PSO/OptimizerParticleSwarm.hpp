@@ -0,0 +1,52 @@
+#ifndef _RHAPSODIES_OPTIMIZERPARTICLESWARM
+#define _RHAPSODIES_OPTIMIZERPARTICLESWARM
+
+#include <GL/gl.h>
+
+#include "Optimizer.hpp"
+
+namespace rhapsodies {
+	/**
+	 * Particle swarm step of update_swarm.comp. The cognitive
+	 * factor and the constriction (inertia) factor are interpolated
+	 * linearly over the generations of a frame, the social term
+	 * follows either gbest or the best of the ring neighbors.
+	 *
+	 * With bFused the program is pso_step.comp, which also scores
+	 * the batch and finds gbest in a single work group. Its score
+	 * and convergence uniforms are set by the HandTracker.
+	 */
+	class OptimizerParticleSwarm : public Optimizer {
+	public:
+		struct Parameters {
+			unsigned int iSwarmSize;
+			unsigned int iGenerations;
+			float fPhiCognitiveBegin;
+			float fPhiCognitiveEnd;
+			float fInertiaBegin;
+			float fInertiaEnd;
+			bool bRingTopology;
+			bool bFused;         // idProgram is pso_step.comp
+			unsigned int iRandomSeed;
+		};
+
+		OptimizerParticleSwarm(GLuint idProgram, const Parameters &oParams);
+
+		std::string GetName();
+		void Step(unsigned int iFrame, unsigned int iGeneration);
+
+	private:
+		GLuint m_idProgram;
+		Parameters m_oParams;
+
+		GLint m_locPhiCognitiveUniform;
+		GLint m_locPhiSocialUniform;
+		GLint m_locInertiaUniform;
+		GLint m_locRingTopologyUniform;
+		GLint m_locRandomSeedUniform;
+		GLint m_locRandomFrameUniform;
+		GLint m_locRandomGenerationUniform;
+	};
+}
+
+#endif // _RHAPSODIES_OPTIMIZERPARTICLESWARM
@@ -7,7 +7,9 @@
 namespace rhapsodies {
 
 	/**
-	 * 
+	 * A single two-handed pose with its penalty. The swarm itself is
+	 * kept in the contiguous state arrays of ParticleSwarm, Particle
+	 * is used for the best pose and conversions from/to state arrays.
 	 */
 	class Particle {
     public:
@@ -17,31 +19,18 @@ namespace rhapsodies {
 		HandModel *GetHandModelLeft();
 		HandModel *GetHandModelRight();
 
-		HandModel *GetIBestModelLeft();
-		HandModel *GetIBestModelRight();
-
 		float GetIBestPenalty();
 		void SetIBestPenalty(float fPenalty);
 		
-		std::vector<float>& GetVelocity();
-		void SetVelocity(std::vector<float> &vecVelocity);
-		void ResetVelocity();
-		
-		void InitializeAround(Particle &oCenter);
-
-		static void StateArrayToParticle(Particle *pParticle, float *aState);
+		static void StateArrayToParticle(Particle *pParticle,
+										 const float *aState);
 		static void ParticleToStateArray(Particle *pParticle, float *aState);		
 
     private:
 		HandModel m_oModelLeft;
 		HandModel m_oModelRight;
-		
-		HandModel m_oIBestModelLeft;
-		HandModel m_oIBestModelRight;
 
 		float     m_fIBestPenalty;
-
-		std::vector<float> m_vecVelocity;
 	};
 }
 
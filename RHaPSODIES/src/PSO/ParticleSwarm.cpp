@@ -1,53 +1,237 @@
-#include <cassert>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
-#include <GL/glew.h>
+#include "../Halton.hpp"
+#include "Particle.hpp"
+#include "ParticleSwarm.hpp"
 
-#include <VistaBase/VistaStreamUtils.h>
+namespace {
+	const float fMaxAngOffset = 1.0f;
+	const float fMaxPosOffset = 0.02f;
+	const float fMaxOriOffset = 0.05f;
 
-#include <VistaTools/VistaRandomNumberGenerator.h>
+	const float fIBestPenaltyReset = 1e20;
 
-#include "Particle.hpp"
-#include "ParticleSwarm.hpp"
+	// weight of the latest frame in the velocity estimate
+	const float fMotionSmoothing = 0.5f;
+
+	void NormalizeQuaternion(float *aQuat) {
+		float fNorm = std::sqrt(aQuat[0]*aQuat[0] + aQuat[1]*aQuat[1] +
+								aQuat[2]*aQuat[2] + aQuat[3]*aQuat[3]);
+		for(int dim = 0; dim < 4; ++dim)
+			aQuat[dim] /= fNorm;
+	}
+}
 
 namespace rhapsodies {
 	ParticleSwarm::ParticleSwarm(size_t nParticles) :
-		m_vecParticles(nParticles) {
+		m_nParticles(nParticles),
+		m_vecStates(nParticles*iStateSize),
+		m_vecIBestStates(nParticles*iStateSize),
+		m_vecVelocities(nParticles*iStateSize, 0.0f),
+		m_vecOrder(nParticles),
+		m_vecCenter(iStateSize),
+		m_vecRandom(iStateSize),
+		m_vecMaxOffset(iStateSize, 0.0f),
+		m_vecOffset(iStateSize, 0.0f),
+		m_vecMotionPrevious(iStateSize, 0.0f),
+		m_vecMotionVelocity(iStateSize, 0.0f),
+		m_bMotionValid(false),
+		m_fMotionDamping(0.0f),
+		m_fMotionSpread(0.0f),
+		m_iRandomSeed(0),
+		m_bHalton(false) {
+
+		// per-dimension maximum randomization offsets. the w
+		// component of the position and the padding/penalty slots
+		// stay at zero so they are copied verbatim from the center.
+		using namespace HandStateLayout;
+		for(size_t offset = 0; offset < iStateSize; offset += iHandStride) {
+			for(size_t dim = 0; dim < iJointCount; ++dim)
+				m_vecMaxOffset[offset+iJointOffset+dim] = fMaxAngOffset;
+			for(size_t dim = 0; dim < 3; ++dim)
+				m_vecMaxOffset[offset+iPositionOffset+dim] = fMaxPosOffset;
+			for(size_t dim = 0; dim < iOrientationSize; ++dim)
+				m_vecMaxOffset[offset+iOrientationOffset+dim] = fMaxOriOffset;
+		}
+
+		Particle oInitial;
+		for(size_t index = 0; index < m_nParticles; ++index) {
+			Particle::ParticleToStateArray(
+				&oInitial, &m_vecStates[index*iStateSize]);
+			Particle::ParticleToStateArray(
+				&oInitial, &m_vecIBestStates[index*iStateSize]);
+		}
 	}
 	
 	ParticleSwarm::~ParticleSwarm() {
 	}
 
-	ParticleSwarm::ParticleVec& ParticleSwarm::GetParticles() {
-		return m_vecParticles;
+	size_t ParticleSwarm::GetParticleCount() {
+		return m_nParticles;
+	}
+
+	float *ParticleSwarm::GetStates() {
+		return m_vecStates.data();
+	}
+
+	float *ParticleSwarm::GetIBestStates() {
+		return m_vecIBestStates.data();
+	}
+
+	float *ParticleSwarm::GetVelocities() {
+		return m_vecVelocities.data();
 	}
 
 	Particle& ParticleSwarm::GetParticleBest() {
 		return m_oParticleBest;
 	}
+
+	void ParticleSwarm::ResetIBestPenalties() {
+		// decoupled hands keep one ibest penalty per hand block
+		for(size_t index = 0; index < m_nParticles; ++index) {
+			for(size_t hand = 0; hand < HandStateLayout::iHandCount; ++hand) {
+				m_vecIBestStates[index*iStateSize +
+								 hand*HandStateLayout::iHandStride +
+								 HandStateLayout::iPenaltyOffset] =
+					fIBestPenaltyReset;
+			}
+		}
+	}
 	
-	void ParticleSwarm::InitializeAroundBest(int iKeepKBest) {
+	void ParticleSwarm::SetMotionModel(float fDamping, float fSpread) {
+		m_fMotionDamping = fDamping;
+		m_fMotionSpread  = fSpread;
+	}
+
+	void ParticleSwarm::ResetMotion() {
+		m_bMotionValid = false;
+		std::fill(m_vecMotionVelocity.begin(), m_vecMotionVelocity.end(), 0.0f);
+	}
+
+	void ParticleSwarm::SetRandomSeed(Philox::uint32 iSeed) {
+		m_iRandomSeed = iSeed;
+	}
+
+	void ParticleSwarm::SetHaltonSpread(bool bHalton) {
+		m_bHalton = bHalton;
+	}
+
+	void ParticleSwarm::InitializeAroundBest(int iKeepKBest,
+											 Philox::uint32 iFrame) {
 		// sort by ibest score, keep best k entries, next-worst is set
-		// to best particle, rest is reset.
-		
+		// to best particle, rest is reset. only the particle indices
+		// are sorted, the state arrays are not moved around.
+		for(size_t index = 0; index < m_nParticles; ++index) {
+			m_vecOrder[index] = index;
+		}
+
+		const float *aIBest = m_vecIBestStates.data();
 		std::sort(
-			m_vecParticles.begin(), m_vecParticles.end(),
-			[](Particle pA, Particle pB) {
-				return pA.GetIBestPenalty() > pB.GetIBestPenalty();   
+			m_vecOrder.begin(), m_vecOrder.end(),
+			[aIBest](size_t iA, size_t iB) {
+				return aIBest[iA*iStateSize + HandStateLayout::iPenaltyOffset] <
+					aIBest[iB*iStateSize + HandStateLayout::iPenaltyOffset];
 			});
 
-		auto it=m_vecParticles.begin();
-		for(; it != m_vecParticles.begin()+iKeepKBest; ++it) {
-			// keep state and velocity (do nothing) OR
-			// reset to ibest solution and reset velocity
-			*(it->GetHandModelLeft()) = *(it->GetIBestModelLeft());
-			it->ResetVelocity();
+		Particle::ParticleToStateArray(&m_oParticleBest, m_vecCenter.data());
+		PredictMotion();
+
+		size_t nKeep = std::min(size_t(std::max(iKeepKBest, 0)), m_nParticles);
+		for(size_t rank = 0; rank < m_nParticles; ++rank) {
+			size_t index = m_vecOrder[rank];
+			float *aState = &m_vecStates[index*iStateSize];
+
+			if(rank < nKeep) {
+				// reset to ibest solution
+				std::memcpy(aState, &m_vecIBestStates[index*iStateSize],
+							iStateSize*sizeof(float));
+			}
+			else if(rank == nKeep) {
+				std::memcpy(aState, m_vecCenter.data(),
+							iStateSize*sizeof(float));
+			}
+			else {
+				// halton points by rank among the re-seeded particles
+				RandomizeAround(aState, m_vecCenter.data(), index, iFrame,
+								rank - nKeep - 1, m_nParticles - nKeep - 1);
+			}
+
+			std::fill_n(&m_vecVelocities[index*iStateSize], iStateSize, 0.0f);
+		}
+	}
+
+	void ParticleSwarm::PredictMotion() {
+		// dimensions without randomization offset (padding, penalty)
+		// are not predicted
+		float *aCenter = m_vecCenter.data();
+		float *aPrevious = m_vecMotionPrevious.data();
+		float *aVelocity = m_vecMotionVelocity.data();
+		const float *aMaxOffset = m_vecMaxOffset.data();
+		float *aOffset = m_vecOffset.data();
+
+		for(size_t dim = 0; dim < iStateSize; ++dim) {
+			float fVelocity = 0.0f;
+			if(m_bMotionValid && aMaxOffset[dim] > 0.0f) {
+				fVelocity = aVelocity[dim] + fMotionSmoothing *
+					(aCenter[dim] - aPrevious[dim] - aVelocity[dim]);
+			}
+
+			aPrevious[dim] = aCenter[dim];
+			aVelocity[dim] = fVelocity;
+
+			aCenter[dim] += m_fMotionDamping*fVelocity;
+			aOffset[dim] = aMaxOffset[dim] + m_fMotionSpread*std::fabs(fVelocity);
+		}
+		m_bMotionValid = true;
+
+		for(size_t offset = 0; offset < iStateSize;
+			offset += HandStateLayout::iHandStride) {
+			NormalizeQuaternion(
+				aCenter + offset + HandStateLayout::iOrientationOffset);
+		}
+	}
+
+	void ParticleSwarm::RandomizeAround(float *aState, const float *aCenter,
+										size_t index, Philox::uint32 iFrame,
+										size_t iSample, size_t nSamples) {
+		float *aRandom = m_vecRandom.data();
+		const float *aOffset = m_vecOffset.data();
+
+		// same counters as initialize_swarm.comp, one block per
+		// dimension of which the first value is used
+		const Philox::uint32 aKey[2] = { m_iRandomSeed,
+										 Philox::STREAM_SWARM_INIT };
+		for(size_t dim = 0; dim < iStateSize; ++dim) {
+			const Philox::uint32 aCounter[4] = {
+				iFrame, 0, Philox::uint32(index), Philox::uint32(dim) };
+			Philox::uint32 aResult[4];
+			Philox::Generate(aCounter, aKey, aResult);
+
+			float r = Philox::ToUnitFloat(aResult[0]);
+
+			// the uniform number places the point within its stratum
+			int iHaltonDim = Halton::GetStateDimension(dim);
+			if(m_bHalton && iHaltonDim >= 0) {
+				r = Halton::Sample(Philox::uint32(iSample), iHaltonDim,
+								   Philox::uint32(nSamples),
+								   iFrame, 0, m_iRandomSeed, r);
+			}
+
+			aRandom[dim] = 2.0f*r - 1.0f;
 		}
 
-		*it = m_oParticleBest;
-		++it;
+		// branch-free over all dimensions, so the compiler can
+		// vectorize it. zero offsets leave padding untouched.
+		for(size_t dim = 0; dim < iStateSize; ++dim) {
+			aState[dim] = aCenter[dim] + aRandom[dim]*aOffset[dim];
+		}
 
-		for(; it != m_vecParticles.end(); ++it) {
-			it->InitializeAround(m_oParticleBest);
+		for(size_t offset = 0; offset < iStateSize;
+			offset += HandStateLayout::iHandStride) {
+			NormalizeQuaternion(
+				aState + offset + HandStateLayout::iOrientationOffset);
 		}
 	}
 }
@@ -3,23 +3,89 @@
 
 #include <vector>
 
+#include "../HandStateLayout.hpp"
+#include "../Philox.hpp"
+#include "Particle.hpp"
+
 namespace rhapsodies {
-	class Particle;
+	/**
+	 * Structure of arrays swarm store. Particle states, ibest states
+	 * and velocities are each stored contiguously with the same
+	 * 64-float per particle layout as the hand model SSBOs, so they
+	 * can be copied from/to the GPU with a single memcpy. All swarm
+	 * operations work in place on preallocated storage.
+	 */
 	class ParticleSwarm {
     public:
-		typedef std::vector<Particle> ParticleVec;
-		
+		static const size_t iStateSize = HandStateLayout::iParticleStride;
+
 		ParticleSwarm(size_t nParticles);
 		~ParticleSwarm();
 
-		ParticleVec& GetParticles();
+		size_t GetParticleCount();
+
+		float *GetStates();
+		float *GetIBestStates();
+		float *GetVelocities();
+
 		Particle& GetParticleBest();
 
-		void InitializeAroundBest(int iKeepKBest);
+		void ResetIBestPenalties();
+
+		/**
+		 * Random offsets are drawn from the Philox stream of the
+		 * given seed and frame, matching initialize_swarm.comp.
+		 */
+		void SetRandomSeed(Philox::uint32 iSeed);
+		void InitializeAroundBest(int iKeepKBest, Philox::uint32 iFrame);
+
+		/**
+		 * Spreads the swarm by a scrambled Halton sequence instead of
+		 * independent random offsets, see Halton.hpp.
+		 */
+		void SetHaltonSpread(bool bHalton);
+
+		/**
+		 * Constant velocity motion model for InitializeAroundBest:
+		 * the swarm is seeded around the best particle extrapolated
+		 * by fDamping times its smoothed per frame change, the
+		 * randomization offsets grow by fSpread times the change.
+		 */
+		void SetMotionModel(float fDamping, float fSpread);
+		void ResetMotion();
 
     private:
-		ParticleVec m_vecParticles;
+		void PredictMotion();
+		// index selects the random stream, iSample of nSamples the
+		// halton point
+		void RandomizeAround(float *aState, const float *aCenter,
+							 size_t index, Philox::uint32 iFrame,
+							 size_t iSample, size_t nSamples);
+		
+		size_t m_nParticles;
+
+		std::vector<float> m_vecStates;
+		std::vector<float> m_vecIBestStates;
+		std::vector<float> m_vecVelocities;
+
+		// scratch storage for InitializeAroundBest
+		std::vector<size_t> m_vecOrder;
+		std::vector<float>  m_vecCenter;
+		std::vector<float>  m_vecRandom;
+		std::vector<float>  m_vecMaxOffset;
+		std::vector<float>  m_vecOffset;
+
+		// best particle of the previous frame and its smoothed change
+		std::vector<float> m_vecMotionPrevious;
+		std::vector<float> m_vecMotionVelocity;
+		bool  m_bMotionValid;
+		float m_fMotionDamping;
+		float m_fMotionSpread;
+
 		Particle m_oParticleBest;
+
+		Philox::uint32 m_iRandomSeed;
+		bool m_bHalton;
 	};
 }
 
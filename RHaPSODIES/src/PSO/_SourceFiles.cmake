@@ -5,6 +5,9 @@ set( RelativeSourceGroup "source\\PSO" )
 
 set( DirFiles
 	 ParticleSwarm.cpp
+	 OptimizerParticleSwarm.cpp
+	 OptimizerCMAES.cpp
+	 LevenbergMarquardt.cpp
 	 Particle.cpp
 	 _SourceFiles.cmake
 )
@@ -0,0 +1,63 @@
+#include <sstream>
+
+#include "Philox.hpp"
+
+namespace {
+	typedef rhapsodies::Philox::uint32 uint32;
+
+	const uint32 iMultiplier0 = 0xD2511F53u;
+	const uint32 iMultiplier1 = 0xCD9E8D57u;
+	const uint32 iWeyl0       = 0x9E3779B9u;
+	const uint32 iWeyl1       = 0xBB67AE85u;
+
+	const int iRounds = 10;
+
+	void MulHiLo(uint32 a, uint32 b, uint32 &hi, uint32 &lo) {
+		VistaType::uint64 product = VistaType::uint64(a) * b;
+		hi = uint32(product >> 32);
+		lo = uint32(product);
+	}
+}
+
+namespace rhapsodies {
+	namespace Philox {
+		void Generate(const uint32 aCounter[4],
+					  const uint32 aKey[2],
+					  uint32 aResult[4]) {
+			uint32 c[4] = { aCounter[0], aCounter[1], aCounter[2], aCounter[3] };
+			uint32 k[2] = { aKey[0], aKey[1] };
+
+			for(int round = 0; round < iRounds; ++round) {
+				uint32 hi0, lo0, hi1, lo1;
+				MulHiLo(iMultiplier0, c[0], hi0, lo0);
+				MulHiLo(iMultiplier1, c[2], hi1, lo1);
+
+				c[0] = hi1 ^ c[1] ^ k[0];
+				c[1] = lo1;
+				c[2] = hi0 ^ c[3] ^ k[1];
+				c[3] = lo0;
+
+				k[0] += iWeyl0;
+				k[1] += iWeyl1;
+			}
+
+			for(int i = 0; i < 4; ++i)
+				aResult[i] = c[i];
+		}
+
+		float ToUnitFloat(uint32 iValue) {
+			return float(iValue >> 8) * (1.0f / 16777216.0f);
+		}
+
+		std::string GenerateGlslHeader() {
+			std::ostringstream oss;
+
+			oss << "#define PHILOX_STREAM_SWARM_INIT "      << STREAM_SWARM_INIT      << "\n"
+				<< "#define PHILOX_STREAM_SWARM_UPDATE "    << STREAM_SWARM_UPDATE    << "\n"
+				<< "#define PHILOX_STREAM_CMAES_SAMPLE "    << STREAM_CMAES_SAMPLE    << "\n"
+				<< "#define PHILOX_STREAM_HALTON_SCRAMBLE " << STREAM_HALTON_SCRAMBLE << "\n";
+
+			return oss.str();
+		}
+	}
+}
@@ -0,0 +1,46 @@
+#ifndef _RHAPSODIES_PHILOX
+#define _RHAPSODIES_PHILOX
+
+#include <string>
+
+#include <VistaBase/VistaBaseTypes.h>
+
+namespace rhapsodies {
+	/**
+	 * Philox4x32-10 counter-based random number generator. Each
+	 * (counter, key) pair maps to four independent 32 bit values,
+	 * so random numbers can be addressed by frame, generation,
+	 * particle and dimension instead of being drawn sequentially.
+	 * shaders/philox.part is the bit-identical GLSL counterpart,
+	 * the stream identifiers are handed to the shaders as PHILOX_*
+	 * defines, see GenerateGlslHeader().
+	 */
+	namespace Philox {
+		typedef VistaType::uint32 uint32;
+
+		/**
+		 * Independent streams per consumer, used as second key word
+		 * next to the seed.
+		 */
+		enum Stream {
+			STREAM_SWARM_INIT      = 0,
+			STREAM_SWARM_UPDATE    = 1,
+			STREAM_CMAES_SAMPLE    = 2,
+			STREAM_HALTON_SCRAMBLE = 3
+		};
+
+		void Generate(const uint32 aCounter[4],
+					  const uint32 aKey[2],
+					  uint32 aResult[4]);
+
+		/**
+		 * Maps the upper 24 bits to [0, 1), exactly representable
+		 * as float on the CPU and the GPU.
+		 */
+		float ToUnitFloat(uint32 iValue);
+
+		std::string GenerateGlslHeader();
+	}
+}
+
+#endif // _RHAPSODIES_PHILOX
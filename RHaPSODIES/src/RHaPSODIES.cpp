@@ -3,9 +3,13 @@
 #include <GL/glew.h>
 
 #include <VistaAspects/VistaDeSerializer.h>
+#include <VistaBase/VistaStreamUtils.h>
+#include <VistaBase/VistaTimeUtils.h>
 #include <VistaTools/VistaEnvironment.h>
 
 #include "RHaPSODIES.hpp"
+#include "HandStateLayout.hpp"
+#include "Philox.hpp"
 
 IVistaDeSerializer &operator>> ( IVistaDeSerializer & ser, const unsigned char* val )
 {
@@ -40,6 +44,8 @@ namespace rhapsodies {
 		"PARTICLE_SWARM";
 	const std::string RHaPSODIES::sEvaluationSectionName =
 		"EVALUATION";
+	const std::string RHaPSODIES::sShaderCacheDirectory =
+		"shadercache";
 
 
 	ShaderRegistry *RHaPSODIES::S_pShaderRegistry = NULL;
@@ -47,8 +53,19 @@ namespace rhapsodies {
 	bool RHaPSODIES::Initialize() {
 		glewInit();
 		
+		const VistaTimer &oTimer = VistaTimeUtils::GetStandardTimer();
+		VistaType::microtime tStart = oTimer.GetMicroTime();
+
 		S_pShaderRegistry = new ShaderRegistry();
-   		return RegisterShaders();
+   		bool bSuccess = RegisterShaders();
+
+		vstr::out() << "Shader registration: "
+					<< 1e3*(oTimer.GetMicroTime() - tStart) << " ms, "
+					<< S_pShaderRegistry->GetCachedProgramCount() << " of "
+					<< S_pShaderRegistry->GetProgramCount()
+					<< " programs from cache" << std::endl;
+
+		return bSuccess;
 	}
 	
 	ShaderRegistry *RHaPSODIES::GetShaderRegistry() {
@@ -58,10 +75,25 @@ namespace rhapsodies {
 	bool RHaPSODIES::RegisterShaders() {
 		std::string sShaderPath =
 			VistaEnvironment::GetEnv("RHAPSODIES_SHADER_PATH");
+
+		// linked programs are cached across runs, without
+		// RHAPSODIES_SHADER_CACHE in shadercache/ of the working directory
+		std::string sShaderCache =
+			VistaEnvironment::GetEnv("RHAPSODIES_SHADER_CACHE");
+		if(sShaderCache.empty())
+			sShaderCache = sShaderCacheDirectory;
+		S_pShaderRegistry->SetCacheDirectory(sShaderCache);
+
+		// all shaders share the particle state layout and the random
+		// streams with the CPU side
+		S_pShaderRegistry->SetSourceHeader(
+			HandStateLayout::GenerateGlslHeader() +
+			Philox::GenerateGlslHeader());
 		
 		S_pShaderRegistry->RegisterShader(
 			"vert_vpos_indexedtransform", GL_VERTEX_SHADER,
-			{sShaderPath + "/vpos_indexedtransform.vert"});
+			{sShaderPath + "/vpos_indexedtransform.vert",
+			 sShaderPath + "/split_hands.part"});
 		S_pShaderRegistry->RegisterShader(
 			"vert_vpos_vnorm_indexedtransform", GL_VERTEX_SHADER,
 			{sShaderPath + "/vpos_vnorm_indexedtransform.vert"});
@@ -78,59 +110,96 @@ namespace rhapsodies {
 			{sShaderPath + "/indexed_viewport.geom"});
 
 		S_pShaderRegistry->RegisterShader(
-			"reduction0_difference", GL_COMPUTE_SHADER,
-			{sShaderPath + "/reduction_header0_difference.part",
-			 sShaderPath + "/reduction.comp"});
-		S_pShaderRegistry->RegisterShader(
-			"reduction1_difference", GL_COMPUTE_SHADER,
-			{sShaderPath + "/reduction_header1_difference.part",
-			 sShaderPath + "/reduction.comp"});
-		S_pShaderRegistry->RegisterShader(
-			"reduction2_difference", GL_COMPUTE_SHADER,
-			{sShaderPath + "/reduction_header2_difference.part",
-			 sShaderPath + "/reduction.comp"});
-
-		S_pShaderRegistry->RegisterShader(
-			"reduction0_union", GL_COMPUTE_SHADER,
-			{sShaderPath + "/reduction_header0_union.part",
-			 sShaderPath + "/reduction.comp"});
+			"vert_impostor", GL_VERTEX_SHADER,
+			{sShaderPath + "/impostor.vert"});
 		S_pShaderRegistry->RegisterShader(
-			"reduction1_union", GL_COMPUTE_SHADER,
-			{sShaderPath + "/reduction_header1_union.part",
-			 sShaderPath + "/reduction.comp"});
+			"geom_impostor", GL_GEOMETRY_SHADER,
+			{sShaderPath + "/impostor.geom",
+			 sShaderPath + "/split_hands.part"});
 		S_pShaderRegistry->RegisterShader(
-			"reduction2_union", GL_COMPUTE_SHADER,
-			{sShaderPath + "/reduction_header2_union.part",
-			 sShaderPath + "/reduction.comp"});
+			"frag_impostor", GL_FRAGMENT_SHADER,
+			{sShaderPath + "/impostor.frag"});
 
+		// transforms straight from the particle state, without
+		// generate_transforms
+		ShaderRegistry::Defines mapStateTransforms;
+		mapStateTransforms["STATE_TRANSFORMS"] = "1";
 		S_pShaderRegistry->RegisterShader(
-			"reduction0_intersection", GL_COMPUTE_SHADER,
-			{sShaderPath + "/reduction_header0_intersection.part",
-			 sShaderPath + "/reduction.comp"});
+			"vert_vpos_statetransform", GL_VERTEX_SHADER,
+			{sShaderPath + "/vpos_indexedtransform.vert",
+			 sShaderPath + "/state_transform.part",
+			 sShaderPath + "/hand_kinematics.part",
+			 sShaderPath + "/split_hands.part"},
+			mapStateTransforms);
 		S_pShaderRegistry->RegisterShader(
-			"reduction1_intersection", GL_COMPUTE_SHADER,
-			{sShaderPath + "/reduction_header1_intersection.part",
-			 sShaderPath + "/reduction.comp"});
-		S_pShaderRegistry->RegisterShader(
-			"reduction2_intersection", GL_COMPUTE_SHADER,
-			{sShaderPath + "/reduction_header2_intersection.part",
-			 sShaderPath + "/reduction.comp"});
+			"vert_impostor_statetransform", GL_VERTEX_SHADER,
+			{sShaderPath + "/impostor.vert",
+			 sShaderPath + "/state_transform.part",
+			 sShaderPath + "/hand_kinematics.part"},
+			mapStateTransforms);
 
 		S_pShaderRegistry->RegisterShader(
-			"prepare_reduction_textures", GL_COMPUTE_SHADER,
-			{sShaderPath + "/prepare_reduction_textures.comp"});
+			"reduce_depth_maps", GL_COMPUTE_SHADER,
+			{sShaderPath + "/reduction.part",
+			 sShaderPath + "/reduce_depth_maps.comp"});
 		S_pShaderRegistry->RegisterShader(
 			"generate_transforms", GL_COMPUTE_SHADER,
-			{sShaderPath + "/generate_transforms.comp"});
+			{sShaderPath + "/generate_transforms.comp",
+			 sShaderPath + "/hand_kinematics.part"});
 		S_pShaderRegistry->RegisterShader(
 			"update_scores", GL_COMPUTE_SHADER,
-			{sShaderPath + "/update_scores.comp"});
+			{sShaderPath + "/reduction.part",
+			 sShaderPath + "/update_scores.comp",
+			 sShaderPath + "/penalty.part"});
 		S_pShaderRegistry->RegisterShader(
 			"update_gbest", GL_COMPUTE_SHADER,
-			{sShaderPath + "/update_gbest.comp"});
+			{sShaderPath + "/update_gbest.comp",
+			 sShaderPath + "/convergence.part",
+			 sShaderPath + "/joint_bounds.part"});
 		S_pShaderRegistry->RegisterShader(
 			"update_swarm", GL_COMPUTE_SHADER,
-			{sShaderPath + "/update_swarm.comp"});
+			{sShaderPath + "/update_swarm.comp",
+			 sShaderPath + "/convergence.part",
+			 sShaderPath + "/ring_topology.part",
+			 sShaderPath + "/philox.part",
+			 sShaderPath + "/joint_bounds.part"});
+		S_pShaderRegistry->RegisterShader(
+			"pso_step", GL_COMPUTE_SHADER,
+			{sShaderPath + "/reduction.part",
+			 sShaderPath + "/pso_step.comp",
+			 sShaderPath + "/penalty.part",
+			 sShaderPath + "/convergence.part",
+			 sShaderPath + "/ring_topology.part",
+			 sShaderPath + "/philox.part",
+			 sShaderPath + "/joint_bounds.part"});
+		S_pShaderRegistry->RegisterShader(
+			"initialize_swarm", GL_COMPUTE_SHADER,
+			{sShaderPath + "/initialize_swarm.comp",
+			 sShaderPath + "/philox.part",
+			 sShaderPath + "/halton.part"});
+		S_pShaderRegistry->RegisterShader(
+			"cmaes_update", GL_COMPUTE_SHADER,
+			{sShaderPath + "/cmaes_update.comp"});
+		S_pShaderRegistry->RegisterShader(
+			"cmaes_sample", GL_COMPUTE_SHADER,
+			{sShaderPath + "/cmaes_sample.comp",
+			 sShaderPath + "/convergence.part",
+			 sShaderPath + "/philox.part",
+			 sShaderPath + "/joint_bounds.part"});
+		S_pShaderRegistry->RegisterShader(
+			"refine_jacobian", GL_COMPUTE_SHADER,
+			{sShaderPath + "/refine_jacobian.comp",
+			 sShaderPath + "/refine_dofs.part"});
+		S_pShaderRegistry->RegisterShader(
+			"refine_solve", GL_COMPUTE_SHADER,
+			{sShaderPath + "/reduction.part",
+			 sShaderPath + "/refine_solve.comp",
+			 sShaderPath + "/refine_dofs.part",
+			 sShaderPath + "/penalty.part",
+			 sShaderPath + "/joint_bounds.part"});
+		S_pShaderRegistry->RegisterShader(
+			"refine_accept", GL_COMPUTE_SHADER,
+			{sShaderPath + "/refine_accept.comp"});
 
 		std::vector<std::string> vec_shaders;
 
@@ -146,38 +215,41 @@ namespace rhapsodies {
 		S_pShaderRegistry->RegisterProgram("shaded_indexedtransform", vec_shaders);
 
 		vec_shaders.clear();
-		vec_shaders.push_back("prepare_reduction_textures");
-		S_pShaderRegistry->RegisterProgram("prepare_reduction_textures", vec_shaders);
+		vec_shaders.push_back("vert_impostor");
+		vec_shaders.push_back("geom_impostor");
+		vec_shaders.push_back("frag_impostor");
+		S_pShaderRegistry->RegisterProgram("impostor", vec_shaders);
 
 		vec_shaders.clear();
-		vec_shaders.push_back("reduction0_difference");
-		S_pShaderRegistry->RegisterProgram("reduction0_difference", vec_shaders);
-		vec_shaders.clear();
-		vec_shaders.push_back("reduction1_difference");
-		S_pShaderRegistry->RegisterProgram("reduction1_difference", vec_shaders);
-		vec_shaders.clear();
-		vec_shaders.push_back("reduction2_difference");
-		S_pShaderRegistry->RegisterProgram("reduction2_difference", vec_shaders);
+		vec_shaders.push_back("vert_vpos_statetransform");
+		vec_shaders.push_back("frag_solid_colored");
+		vec_shaders.push_back("indexed_viewport");
+		S_pShaderRegistry->RegisterProgram("statetransform", vec_shaders);
 
+		// layered targets select the layer in the vertex shader,
+		// fetched with the LAYERED define
 		vec_shaders.clear();
-		vec_shaders.push_back("reduction0_union");
-		S_pShaderRegistry->RegisterProgram("reduction0_union", vec_shaders);
-		vec_shaders.clear();
-		vec_shaders.push_back("reduction1_union");
-		S_pShaderRegistry->RegisterProgram("reduction1_union", vec_shaders);
-		vec_shaders.clear();
-		vec_shaders.push_back("reduction2_union");
-		S_pShaderRegistry->RegisterProgram("reduction2_union", vec_shaders);
+		vec_shaders.push_back("vert_vpos_indexedtransform");
+		vec_shaders.push_back("frag_solid_colored");
+		S_pShaderRegistry->RegisterProgram("indexedtransform_layered",
+										   vec_shaders);
 
 		vec_shaders.clear();
-		vec_shaders.push_back("reduction0_intersection");
-		S_pShaderRegistry->RegisterProgram("reduction0_intersection", vec_shaders);
+		vec_shaders.push_back("vert_vpos_statetransform");
+		vec_shaders.push_back("frag_solid_colored");
+		S_pShaderRegistry->RegisterProgram("statetransform_layered",
+										   vec_shaders);
+
 		vec_shaders.clear();
-		vec_shaders.push_back("reduction1_intersection");
-		S_pShaderRegistry->RegisterProgram("reduction1_intersection", vec_shaders);
+		vec_shaders.push_back("vert_impostor_statetransform");
+		vec_shaders.push_back("geom_impostor");
+		vec_shaders.push_back("frag_impostor");
+		S_pShaderRegistry->RegisterProgram("impostor_statetransform",
+										   vec_shaders);
+
 		vec_shaders.clear();
-		vec_shaders.push_back("reduction2_intersection");
-		S_pShaderRegistry->RegisterProgram("reduction2_intersection", vec_shaders);
+		vec_shaders.push_back("reduce_depth_maps");
+		S_pShaderRegistry->RegisterProgram("reduce_depth_maps", vec_shaders);
 
 		vec_shaders.clear();
 		vec_shaders.push_back("generate_transforms");
@@ -192,6 +264,33 @@ namespace rhapsodies {
 		vec_shaders.clear();
 		vec_shaders.push_back("update_swarm");
 		S_pShaderRegistry->RegisterProgram("update_swarm", vec_shaders);
+		vec_shaders.clear();
+		vec_shaders.push_back("pso_step");
+		S_pShaderRegistry->RegisterProgram("pso_step", vec_shaders);
+		vec_shaders.clear();
+		vec_shaders.push_back("initialize_swarm");
+		S_pShaderRegistry->RegisterProgram("initialize_swarm", vec_shaders);
+		vec_shaders.clear();
+		vec_shaders.push_back("cmaes_update");
+		S_pShaderRegistry->RegisterProgram("cmaes_update", vec_shaders);
+		vec_shaders.clear();
+		vec_shaders.push_back("cmaes_sample");
+		S_pShaderRegistry->RegisterProgram("cmaes_sample", vec_shaders);
+		vec_shaders.clear();
+		vec_shaders.push_back("refine_jacobian");
+		S_pShaderRegistry->RegisterProgram("refine_jacobian", vec_shaders);
+		vec_shaders.clear();
+		vec_shaders.push_back("refine_solve");
+		S_pShaderRegistry->RegisterProgram("refine_solve", vec_shaders);
+		vec_shaders.clear();
+		vec_shaders.push_back("refine_accept");
+		S_pShaderRegistry->RegisterProgram("refine_accept", vec_shaders);
+
+		// the compute programs are specialised on the tracker
+		// configuration, only the render programs are built here
+		S_pShaderRegistry->GetProgram("indexedtransform");
+		S_pShaderRegistry->GetProgram("shaded_indexedtransform");
+		S_pShaderRegistry->WaitForPrograms();
 
 		return true;
 	}
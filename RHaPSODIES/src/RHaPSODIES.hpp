@@ -18,6 +18,7 @@ namespace rhapsodies {
 		static const std::string sRenderingSectionName;
 		static const std::string sParticleSwarmSectionName;
 		static const std::string sEvaluationSectionName;
+		static const std::string sShaderCacheDirectory;
 
 		static bool Initialize();
 		static ShaderRegistry *GetShaderRegistry();
@@ -1,5 +1,10 @@
 #include <iostream>
 #include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include <sys/stat.h>
+#include <sys/types.h>
 
 #include <GL/glew.h>
 
@@ -22,18 +27,129 @@ namespace {
 			result = std::string(buffer.begin(), buffer.end());
 		}
 	}
+
+	void insertAfterVersion(std::string &source, const std::string &lines) {
+		if(lines.empty())
+			return;
+		
+		size_t pos = source.find("#version");
+		if(pos != std::string::npos)
+			pos = source.find('\n', pos);
+
+		if(pos == std::string::npos) {
+			source = lines + source;
+			return;
+		}
+
+		// restore line numbering for compiler messages
+		source.insert(pos+1, lines + "#line 2\n");
+	}
+
+	// moves the #version line of the main shader in front of the
+	// parts listed before it
+	void hoistVersion(std::string &source) {
+		size_t pos = source.find("#version");
+		if(pos == std::string::npos || pos == 0)
+			return;
+
+		size_t end = source.find('\n', pos);
+		end = (end == std::string::npos) ? source.size() : end+1;
+
+		std::string version = source.substr(pos, end-pos);
+		source.erase(pos, end-pos);
+		if(version.back() != '\n')
+			version += '\n';
+		source.insert(0, version);
+	}
+
+	// 64 bit FNV-1a, chained over all parts of a cache key
+	const unsigned long long iHashBasis = 0xcbf29ce484222325ull;
+
+	unsigned long long hashString(const std::string &value,
+								  unsigned long long hash) {
+		for(unsigned char c: value) {
+			hash ^= c;
+			hash *= 0x100000001b3ull;
+		}
+		// separator, so part boundaries change the hash
+		hash ^= 0xff;
+		hash *= 0x100000001b3ull;
+		return hash;
+	}
+
+	std::string defineLines(
+		const rhapsodies::ShaderRegistry::Defines &defines) {
+		std::string lines;
+		for(const auto &define: defines) {
+			lines += "#define " + define.first + " " + define.second + "\n";
+		}
+		return lines;
+	}
+
+	std::string glString(GLenum name) {
+		const GLubyte *value = glGetString(name);
+		return value ? std::string((const char*)value) : std::string();
+	}
+
+	// header of a cache file, followed by the program binary
+	struct ProgramBinaryHeader {
+		unsigned int magic;
+		unsigned long long key;
+		GLenum format;
+		GLint length;
+	};
+
+	const unsigned int iBinaryMagic = 0x42504852; // "RHPB"
 }
 
 namespace rhapsodies {
-	GLuint ShaderRegistry::RegisterShader(std::string name,
-										  GLenum type,
-										  std::vector<std::string> paths) {
+	ShaderRegistry::ShaderRegistry() :
+		m_iCachedPrograms(0) {
+		// compiles and links run on driver threads until their status
+		// is queried, see WaitForPrograms()
+		if(GLEW_KHR_parallel_shader_compile)
+			glMaxShaderCompilerThreadsKHR(0xffffffff);
+	}
+
+	void ShaderRegistry::SetSourceHeader(std::string header) {
+		m_sSourceHeader = header;
+	}
+
+	void ShaderRegistry::SetCacheDirectory(std::string directory) {
+		m_sCacheDirectory.clear();
+		if(directory.empty())
+			return;
+
+		GLint formats = 0;
+		if(GLEW_ARB_get_program_binary)
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		if(formats == 0) {
+			vstr::warn() << "No program binary formats supported, "
+						 << "shader cache disabled." << std::endl;
+			return;
+		}
+
+		if(mkdir(directory.c_str(), 0755) != 0) {
+			struct stat info;
+			if(stat(directory.c_str(), &info) != 0 || !S_ISDIR(info.st_mode)) {
+				vstr::warn() << "Shader cache directory " << directory
+							 << " not available, shader cache disabled."
+							 << std::endl;
+				return;
+			}
+		}
+
+		vstr::debug() << "Shader cache: " << directory << std::endl;
+		m_sCacheDirectory = directory;
+	}
+
+	void ShaderRegistry::RegisterShader(std::string name,
+										GLenum type,
+										std::vector<std::string> paths,
+										Defines defines) {
 
 		vstr::debug() << "Registering shader: " << name << std::endl;
 		
-		// create gl shader object
-		GLuint shader = glCreateShader(type);
-
 		std::string sShader;
 		std::string sShaderCombined;
 		for(std::string &path: paths) {
@@ -41,8 +157,52 @@ namespace rhapsodies {
 			readFileIntoString(path, sShader);
 			sShaderCombined += sShader;
 		}
+		hoistVersion(sShaderCombined);
+
+		ShaderSource &oShader = m_mapShader[name];
+		oShader.type    = type;
+		oShader.source  = sShaderCombined;
+		oShader.defines = defines;
+	}
+
+	std::string ShaderRegistry::VariantName(const std::string &name,
+											const Defines &defines) {
+		if(defines.empty())
+			return name;
+
+		std::ostringstream variant;
+		variant << name << "-" << std::hex << std::setw(16)
+				<< std::setfill('0')
+				<< hashString(defineLines(defines), iHashBasis);
+		return variant.str();
+	}
 
-		const char* strShaderData = sShaderCombined.c_str();
+	std::string ShaderRegistry::ShaderVariantSource(const std::string &name,
+													const Defines &defines) {
+		const ShaderSource &oShader = m_mapShader[name];
+
+		// program defines override the ones of the shader
+		Defines merged = oShader.defines;
+		for(const auto &define: defines) {
+			merged[define.first] = define.second;
+		}
+
+		std::string source = oShader.source;
+		insertAfterVersion(source, m_sSourceHeader + defineLines(merged));
+		return source;
+	}
+
+	GLuint ShaderRegistry::CompileShader(const std::string &name,
+										 const Defines &defines) {
+		CompiledShader &oCompiled = m_mapCompiled[VariantName(name, defines)];
+		if(oCompiled.shader != 0)
+			return oCompiled.shader;
+
+		// create gl shader object
+		GLuint shader = glCreateShader(m_mapShader[name].type);
+
+		std::string source = ShaderVariantSource(name, defines);
+		const char* strShaderData = source.c_str();
 		glShaderSource(shader, 1, &strShaderData, NULL);
 
 		// vstr::out() << "Shader source:" << std::endl
@@ -50,6 +210,19 @@ namespace rhapsodies {
 		
 		glCompileShader(shader);
 
+		oCompiled.shader = shader;
+		oCompiled.checked = false;
+		return shader;
+	}
+
+	void ShaderRegistry::CheckShader(const std::string &name,
+									 const Defines &defines) {
+		CompiledShader &oCompiled = m_mapCompiled[VariantName(name, defines)];
+		if(oCompiled.checked)
+			return;
+		oCompiled.checked = true;
+
+		GLuint shader = oCompiled.shader;
 		GLint status;
 		glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
 		
@@ -61,7 +234,7 @@ namespace rhapsodies {
 			glGetShaderInfoLog(shader, infoLogLength, NULL, strInfoLog);
 
 			const char *strShaderType = NULL;
-			switch(type) {
+			switch(m_mapShader[name].type) {
 			case GL_VERTEX_SHADER: strShaderType = "vertex"; break;
 			case GL_GEOMETRY_SHADER: strShaderType = "geometry"; break;
 			case GL_FRAGMENT_SHADER: strShaderType = "fragment"; break;
@@ -69,46 +242,188 @@ namespace rhapsodies {
 			}
 
 			std::cerr << "Compile failure in " << strShaderType
-					  << " shader: " << name << std::endl
+					  << " shader: " << VariantName(name, defines) << std::endl
 					  << strInfoLog << std::endl;
 			
 			delete[] strInfoLog;
 		}
-
-		m_mapShader[name] = shader;
-		return shader;
 	}
 
-	GLuint ShaderRegistry::RegisterProgram(std::string name,
-										   std::vector<std::string> shader_names) {
+	void ShaderRegistry::RegisterProgram(std::string name,
+										 std::vector<std::string> shader_names) {
 		
 		vstr::debug() << "Registering program: " << name << std::endl;
-		
-		GLuint program = glCreateProgram();
 
-		for(size_t iLoop = 0; iLoop < shader_names.size(); iLoop++)
-			glAttachShader(program, m_mapShader[shader_names[iLoop]]);
+		m_mapProgramShaders[name] = shader_names;
+	}
+
+	GLuint ShaderRegistry::BuildProgram(const std::string &name,
+										const Defines &defines) {
+		PendingProgram oPending;
+		oPending.variant = VariantName(name, defines);
+		oPending.shader_names = m_mapProgramShaders[name];
+		oPending.defines = defines;
+		oPending.key = 0;
+
+		if(!m_sCacheDirectory.empty()) {
+			oPending.key = ProgramKey(oPending.shader_names, defines);
+
+			GLuint program = glCreateProgram();
+			if(LoadProgramBinary(program, oPending.variant, oPending.key)) {
+				m_iCachedPrograms++;
+				m_mapProgram[oPending.variant] = program;
+				return program;
+			}
+			glDeleteProgram(program);
+		}
+
+		// the status is queried once all programs are submitted
+		oPending.program = glCreateProgram();
+
+		for(const std::string &shader_name: oPending.shader_names)
+			glAttachShader(oPending.program,
+						   CompileShader(shader_name, defines));
+
+		if(!m_sCacheDirectory.empty())
+			glProgramParameteri(oPending.program,
+								GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		glLinkProgram(oPending.program);
+
+		m_vecPendingPrograms.push_back(oPending);
+		m_mapProgram[oPending.variant] = oPending.program;
+		return oPending.program;
+	}
+
+	void ShaderRegistry::WaitForPrograms() {
+		for(PendingProgram &oPending: m_vecPendingPrograms) {
+			GLuint program = oPending.program;
 
-		glLinkProgram(program);
+			for(const std::string &shader_name: oPending.shader_names)
+				CheckShader(shader_name, oPending.defines);
+
+			GLint status;
+			glGetProgramiv(program, GL_LINK_STATUS, &status);
+
+			if(status == GL_FALSE)	{
+				GLint infoLogLength;
+				glGetProgramiv(program, GL_INFO_LOG_LENGTH, &infoLogLength);
+
+				GLchar *strInfoLog = new GLchar[infoLogLength + 1];
+				glGetProgramInfoLog(program, infoLogLength, NULL, strInfoLog);
+				std::cerr << "Linker failure in " << oPending.variant << ": "
+						  << strInfoLog << std::endl;
+				delete[] strInfoLog;
+			}
+
+			for(const std::string &shader_name: oPending.shader_names)
+				glDetachShader(program,
+							   CompileShader(shader_name, oPending.defines));
+
+			if(!m_sCacheDirectory.empty())
+				StoreProgramBinary(program, oPending.variant, oPending.key);
+		}
+
+		m_vecPendingPrograms.clear();
+	}
+
+	size_t ShaderRegistry::GetCachedProgramCount() const {
+		return m_iCachedPrograms;
+	}
+
+	size_t ShaderRegistry::GetProgramCount() const {
+		return m_mapProgram.size();
+	}
 
+	unsigned long long ShaderRegistry::ProgramKey(
+		const std::vector<std::string> &shader_names,
+		const Defines &defines) {
+		// binaries are only valid for the driver that created them
+		unsigned long long key = iHashBasis;
+		key = hashString(glString(GL_VENDOR), key);
+		key = hashString(glString(GL_RENDERER), key);
+		key = hashString(glString(GL_VERSION), key);
+
+		for(const std::string &shader_name: shader_names) {
+			std::ostringstream type;
+			type << m_mapShader[shader_name].type;
+
+			key = hashString(shader_name, key);
+			key = hashString(type.str(), key);
+			key = hashString(ShaderVariantSource(shader_name, defines), key);
+		}
+
+		return key;
+	}
+
+	std::string ShaderRegistry::CacheFile(const std::string &variant) {
+		// one file per program variant, a changed key overwrites it
+		return m_sCacheDirectory + "/" + variant + ".bin";
+	}
+
+	bool ShaderRegistry::LoadProgramBinary(GLuint program,
+										   const std::string &name,
+										   unsigned long long key) {
+		std::ifstream file(CacheFile(name).c_str(), std::ios::binary);
+		if(!file)
+			return false;
+
+		ProgramBinaryHeader header;
+		file.read((char*)&header, sizeof(header));
+		if(!file || header.magic != iBinaryMagic || header.key != key ||
+		   header.length <= 0)
+			return false;
+
+		std::vector<char> binary(header.length);
+		file.read(&binary[0], header.length);
+		if(!file)
+			return false;
+
+		// the driver may still reject the binary, e.g. after an
+		// update that kept the version string
+		glProgramBinary(program, header.format, &binary[0], header.length);
+
+		GLint status;
+		glGetProgramiv(program, GL_LINK_STATUS, &status);
+		if(status == GL_FALSE) {
+			vstr::debug() << "Cached binary of " << name
+						  << " rejected, compiling from source." << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	void ShaderRegistry::StoreProgramBinary(GLuint program,
+											const std::string &name,
+											unsigned long long key) {
 		GLint status;
 		glGetProgramiv(program, GL_LINK_STATUS, &status);
+		if(status == GL_FALSE)
+			return;
 
-		if(status == GL_FALSE)	{
-			GLint infoLogLength;
-			glGetProgramiv(program, GL_INFO_LOG_LENGTH, &infoLogLength);
+		ProgramBinaryHeader header;
+		header.magic = iBinaryMagic;
+		header.key = key;
+		header.format = 0;
+		header.length = 0;
 
-			GLchar *strInfoLog = new GLchar[infoLogLength + 1];
-			glGetProgramInfoLog(program, infoLogLength, NULL, strInfoLog);
-			std::cerr << "Linker failure: " << strInfoLog << std::endl;
-			delete[] strInfoLog;
-		}
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &header.length);
+		if(header.length <= 0)
+			return;
 
-		for(size_t iLoop = 0; iLoop < shader_names.size(); iLoop++)
-			glDetachShader(program, m_mapShader[shader_names[iLoop]]);
+		std::vector<char> binary(header.length);
+		glGetProgramBinary(program, header.length, &header.length,
+						   &header.format, &binary[0]);
 
-		m_mapProgram[name] = program;
-		return program;
+		std::ofstream file(CacheFile(name).c_str(),
+						   std::ios::binary | std::ios::trunc);
+		file.write((const char*)&header, sizeof(header));
+		file.write(&binary[0], header.length);
+
+		if(!file) {
+			vstr::warn() << "Could not write shader cache file "
+						 << CacheFile(name) << std::endl;
+		}
 	}
 
 	GLuint ShaderRegistry::RegisterUniform(std::string program_name,
@@ -119,16 +434,23 @@ namespace rhapsodies {
 		return location;		
 	}
 
-	GLuint ShaderRegistry::GetProgram(std::string name) {
-		std::map<std::string, GLuint>::iterator it = m_mapProgram.find(name);
+	GLuint ShaderRegistry::GetProgram(std::string name, Defines defines) {
+		std::map<std::string, GLuint>::iterator it =
+			m_mapProgram.find(VariantName(name, defines));
+		if(it != m_mapProgram.end()) {
+			// the program is about to be used, report its errors
+			if(!m_vecPendingPrograms.empty())
+				WaitForPrograms();
+			return it->second;
+		}
 
-		if(it == m_mapProgram.end()) {
+		if(m_mapProgramShaders.find(name) == m_mapProgramShaders.end()) {
 			vstr::err() << "Program " << name << " not found in ShaderRegistry!"
 						<< std::endl;
 			return ~0;
 		}
 		
-		return it->second;
+		return BuildProgram(name, defines);
 	}
 
 	GLuint ShaderRegistry::GetUniform(std::string program_name,
@@ -9,22 +9,128 @@
 
 namespace rhapsodies {
 	class ShaderRegistry {
-		std::map<std::string, GLuint> m_mapShader;
+	public:
+		/**
+		 * Compile time constants, emitted as "#define name value"
+		 * after the #version directive.
+		 */
+		typedef std::map<std::string, std::string> Defines;
+
+	private:
+		struct ShaderSource {
+			GLenum type;
+			std::string source;
+			Defines defines;
+		};
+
+		// compiled on first use by a program variant
+		struct CompiledShader {
+			CompiledShader() : shader(0), checked(false) {}
+
+			GLuint shader;
+			bool checked;
+		};
+
+		// linked, but the link status was not queried yet
+		struct PendingProgram {
+			std::string variant;
+			std::vector<std::string> shader_names;
+			Defines defines;
+			unsigned long long key;
+			GLuint program;
+		};
+
+		std::map<std::string, ShaderSource> m_mapShader;
+		std::map<std::string, std::vector<std::string> > m_mapProgramShaders;
+		// keyed on the variant name, see VariantName()
+		std::map<std::string, CompiledShader> m_mapCompiled;
 		std::map<std::string, GLuint> m_mapProgram;
 		std::map<std::string, std::map<std::string, GLuint> > m_mapUniform;
 
+		std::string m_sSourceHeader;
+		std::string m_sCacheDirectory;
+
+		std::vector<PendingProgram> m_vecPendingPrograms;
+		size_t m_iCachedPrograms;
+
+		/**
+		 * The plain name without defines, "name-<hash of defines>"
+		 * otherwise. Also used for the cache file.
+		 */
+		std::string VariantName(const std::string &name,
+								const Defines &defines);
+		std::string ShaderVariantSource(const std::string &name,
+										const Defines &defines);
+		GLuint CompileShader(const std::string &name, const Defines &defines);
+		void CheckShader(const std::string &name, const Defines &defines);
+		GLuint BuildProgram(const std::string &name, const Defines &defines);
+
+		unsigned long long ProgramKey(
+			const std::vector<std::string> &shader_names,
+			const Defines &defines);
+		std::string CacheFile(const std::string &variant);
+		bool LoadProgramBinary(GLuint program, const std::string &variant,
+							   unsigned long long key);
+		void StoreProgramBinary(GLuint program, const std::string &variant,
+								unsigned long long key);
+
 	public:
-		GLuint RegisterShader(std::string name,
-							  GLenum type,
-							  std::vector<std::string> paths);
+		ShaderRegistry();
+
+		/**
+		 * Set generated source lines that are inserted right after
+		 * the #version directive of every shader registered
+		 * afterwards, e.g. the HandStateLayout defines.
+		 */
+		void SetSourceHeader(std::string header);
+
+		/**
+		 * Linked programs are cached as driver binaries in this
+		 * directory, keyed on their sources and the GL vendor,
+		 * renderer and version. Empty disables the cache.
+		 */
+		void SetCacheDirectory(std::string directory);
+
+		/**
+		 * Shaders are only compiled when a program variant using
+		 * them is not found in the binary cache. The defines are
+		 * overridden by those of the program variant. The paths are
+		 * concatenated, parts listed before the main shader may hold
+		 * declarations, its #version line is moved to the front.
+		 */
+		void RegisterShader(std::string name,
+							GLenum type,
+							std::vector<std::string> paths,
+							Defines defines = Defines());
+
+		/**
+		 * Only records the shaders, variants are built by
+		 * GetProgram().
+		 */
+		void RegisterProgram(std::string name,
+							 std::vector<std::string> shader_names);
+
+		/**
+		 * Waits for all submitted programs, reports compile and link
+		 * errors and stores the binaries in the cache.
+		 */
+		void WaitForPrograms();
 
-		GLuint RegisterProgram(std::string name,
-							   std::vector<std::string> shader_names);
+		size_t GetCachedProgramCount() const;
+		size_t GetProgramCount() const;
 
 		GLuint RegisterUniform(std::string program_name,
 							   std::string uniform_name);
 
-		GLuint GetProgram(std::string name);
+		/**
+		 * Each set of defines is its own program variant, built and
+		 * cached on first request. Compiles and links are only
+		 * submitted, so the driver can overlap them with
+		 * KHR_parallel_shader_compile. Errors are reported by
+		 * WaitForPrograms() or the next GetProgram() of a built
+		 * variant.
+		 */
+		GLuint GetProgram(std::string name, Defines defines = Defines());
 		GLuint GetUniform(std::string program_name,
 						  std::string uniform_name);
 
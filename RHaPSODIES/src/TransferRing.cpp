@@ -0,0 +1,234 @@
+#include <GL/glew.h>
+
+#include <VistaBase/VistaStreamUtils.h>
+
+#include "TransferRing.hpp"
+
+namespace {
+	// regions start at offsets usable for any buffer binding
+	const size_t iRegionAlignment = 256;
+
+	// wait in steps of 1ms, glClientWaitSync takes no infinite timeout
+	const GLuint64 iWaitStep = 1000000;
+}
+
+namespace rhapsodies {
+	TransferRing::TransferRing(Direction eDirection, size_t iRegionSize,
+							   size_t iRegionCount) :
+		m_eDirection(eDirection),
+		m_iRegionSize((iRegionSize + iRegionAlignment - 1) /
+					  iRegionAlignment * iRegionAlignment),
+		m_iRegionCount(iRegionCount),
+		m_bPersistent(GLEW_ARB_buffer_storage),
+		m_idBuffer(0),
+		m_pMapped(NULL),
+		m_vecFences(iRegionCount, GLsync(0)),
+		m_iHead(0),
+		m_iPending(0),
+		m_iDropped(0) {
+
+		GLsizeiptr iTotalSize = GLsizeiptr(m_iRegionSize*m_iRegionCount);
+		GLbitfield iAccess =
+			(m_eDirection == UPLOAD) ? GL_MAP_WRITE_BIT : GL_MAP_READ_BIT;
+
+		glGenBuffers(1, &m_idBuffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_idBuffer);
+		if(m_bPersistent) {
+			GLbitfield iFlags =
+				iAccess | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glBufferStorage(GL_COPY_WRITE_BUFFER, iTotalSize, NULL, iFlags);
+			m_pMapped = (unsigned char*)glMapBufferRange(
+				GL_COPY_WRITE_BUFFER, 0, iTotalSize, iFlags);
+		}
+		else {
+			glBufferData(GL_COPY_WRITE_BUFFER, iTotalSize, NULL,
+						 (m_eDirection == UPLOAD) ?
+						 GL_STREAM_DRAW : GL_STREAM_READ);
+		}
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+
+	TransferRing::~TransferRing() {
+		if(m_iDropped > 0) {
+			vstr::debug() << "Transfer ring dropped " << m_iDropped
+						  << " readbacks." << std::endl;
+		}
+
+		for(size_t i = 0; i < m_iRegionCount; ++i) {
+			if(m_vecFences[i])
+				glDeleteSync(m_vecFences[i]);
+		}
+
+		if(m_pMapped) {
+			glBindBuffer(GL_COPY_WRITE_BUFFER, m_idBuffer);
+			glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		}
+		glDeleteBuffers(1, &m_idBuffer);
+	}
+
+	GLuint TransferRing::GetBufferId() const {
+		return m_idBuffer;
+	}
+
+	size_t TransferRing::GetRegionSize() const {
+		return m_iRegionSize;
+	}
+
+	bool TransferRing::GetIsPersistent() const {
+		return m_bPersistent;
+	}
+
+	GLintptr TransferRing::GetOffset() const {
+		return GLintptr(m_iHead*m_iRegionSize);
+	}
+
+	void *TransferRing::Map() {
+		// the gpu may still be copying from this region
+		WaitFence(m_iHead, true);
+		return MapRegion(m_iHead);
+	}
+
+	void TransferRing::Unmap() {
+		if(m_bPersistent)
+			return;
+
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_idBuffer);
+		glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+
+	void TransferRing::CopyTo(GLuint idTarget, GLintptr iTargetOffset,
+							  GLintptr iRegionOffset, GLsizeiptr iSize) {
+		glBindBuffer(GL_COPY_READ_BUFFER, m_idBuffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, idTarget);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+							GetOffset() + iRegionOffset, iTargetOffset,
+							iSize);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	}
+
+	void TransferRing::CopyFrom(GLuint idSource, GLintptr iSourceOffset,
+								GLintptr iRegionOffset, GLsizeiptr iSize) {
+		// shader writes to the source have to land before the copy
+		glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+		glBindBuffer(GL_COPY_READ_BUFFER, idSource);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_idBuffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+							iSourceOffset, GetOffset() + iRegionOffset,
+							iSize);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	}
+
+	void TransferRing::Submit() {
+		if(m_eDirection == READBACK && GetIsFull()) {
+			// warn once, a consumer that falls behind drops every frame
+			if(m_iDropped == 0) {
+				vstr::warn() << "Transfer ring full, dropping the oldest "
+							 << "readback. Further drops are counted."
+							 << std::endl;
+			}
+			m_iDropped++;
+			m_iPending--;
+		}
+
+		GLsync &pFence = m_vecFences[m_iHead];
+		if(pFence)
+			glDeleteSync(pFence);
+		pFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+		m_iHead = (m_iHead + 1) % m_iRegionCount;
+		if(m_eDirection == READBACK)
+			m_iPending++;
+	}
+
+	size_t TransferRing::GetPendingCount() const {
+		return m_iPending;
+	}
+
+	size_t TransferRing::GetDroppedCount() const {
+		return m_iDropped;
+	}
+
+	bool TransferRing::GetIsFull() const {
+		return m_iPending == m_iRegionCount;
+	}
+
+	const void *TransferRing::Fetch(bool bWait) {
+		if(m_iPending == 0)
+			return NULL;
+
+		size_t iTail = (m_iHead + m_iRegionCount - m_iPending) % m_iRegionCount;
+		if(!WaitFence(iTail, bWait))
+			return NULL;
+
+		return MapRegion(iTail);
+	}
+
+	void TransferRing::Release() {
+		if(m_iPending == 0)
+			return;
+
+		if(!m_bPersistent) {
+			glBindBuffer(GL_COPY_READ_BUFFER, m_idBuffer);
+			glUnmapBuffer(GL_COPY_READ_BUFFER);
+			glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		}
+		m_iPending--;
+	}
+
+	void TransferRing::Reset() {
+		for( ; m_iPending > 0 ; m_iPending--) {
+			size_t iTail =
+				(m_iHead + m_iRegionCount - m_iPending) % m_iRegionCount;
+			if(m_vecFences[iTail]) {
+				glDeleteSync(m_vecFences[iTail]);
+				m_vecFences[iTail] = 0;
+			}
+		}
+	}
+
+	bool TransferRing::WaitFence(size_t iRegion, bool bWait) {
+		GLsync &pFence = m_vecFences[iRegion];
+		if(!pFence)
+			return true;
+
+		// flush, otherwise the fence may never be submitted
+		GLenum eStatus = glClientWaitSync(pFence, GL_SYNC_FLUSH_COMMANDS_BIT,
+										  bWait ? iWaitStep : 0);
+		while(bWait && eStatus == GL_TIMEOUT_EXPIRED) {
+			eStatus = glClientWaitSync(pFence, 0, iWaitStep);
+		}
+
+		if(eStatus == GL_TIMEOUT_EXPIRED)
+			return false;
+		if(eStatus == GL_WAIT_FAILED) {
+			vstr::warn() << "Transfer ring fence wait failed." << std::endl;
+		}
+
+		glDeleteSync(pFence);
+		pFence = 0;
+		return true;
+	}
+
+	void *TransferRing::MapRegion(size_t iRegion) {
+		if(m_bPersistent)
+			return m_pMapped + iRegion*m_iRegionSize;
+
+		// the fence has passed, the region need not be synchronized
+		GLenum eTarget = (m_eDirection == UPLOAD) ?
+			GL_COPY_WRITE_BUFFER : GL_COPY_READ_BUFFER;
+		GLbitfield iAccess = (m_eDirection == UPLOAD) ?
+			(GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT |
+			 GL_MAP_UNSYNCHRONIZED_BIT) : GL_MAP_READ_BIT;
+
+		glBindBuffer(eTarget, m_idBuffer);
+		void *pRegion = glMapBufferRange(eTarget,
+										 GLintptr(iRegion*m_iRegionSize),
+										 GLsizeiptr(m_iRegionSize), iAccess);
+		glBindBuffer(eTarget, 0);
+		return pRegion;
+	}
+}
@@ -0,0 +1,106 @@
+#ifndef _RHAPSODIES_TRANSFERRING
+#define _RHAPSODIES_TRANSFERRING
+
+#include <vector>
+
+#include <GL/gl.h>
+
+namespace rhapsodies {
+	/**
+	 * Staging buffer for CPU<->GPU transfers without implicit
+	 * synchronisation. The buffer is split into regions that are
+	 * used round robin, each region is guarded by a fence.
+	 *
+	 * With ARB_buffer_storage the buffer is persistently and
+	 * coherently mapped. Otherwise regions are mapped unsynchronized
+	 * on demand, the fences keep this safe.
+	 *
+	 * Uploads: Map() the head region, fill it, Unmap(), copy or
+	 * unpack from GetOffset() and Submit().
+	 *
+	 * Readbacks: copy into GetOffset() and Submit(). Fetch() returns
+	 * the oldest submitted region once the gpu is done with it,
+	 * Release() hands it back.
+	 */
+	class TransferRing {
+	public:
+		enum Direction {
+			UPLOAD,
+			READBACK
+		};
+
+		TransferRing(Direction eDirection, size_t iRegionSize,
+					 size_t iRegionCount = 3);
+		~TransferRing();
+
+		GLuint GetBufferId() const;
+		size_t GetRegionSize() const;
+		bool GetIsPersistent() const;
+
+		/**
+		 * Buffer offset of the head region.
+		 */
+		GLintptr GetOffset() const;
+
+		/**
+		 * Head region of an upload ring. Waits only if the gpu has
+		 * not yet consumed the region from iRegionCount submits ago.
+		 */
+		void *Map();
+		void Unmap();
+
+		/**
+		 * Buffer to buffer copies between the head region and
+		 * another buffer, offsets are relative to the region.
+		 */
+		void CopyTo(GLuint idTarget, GLintptr iTargetOffset,
+					GLintptr iRegionOffset, GLsizeiptr iSize);
+		void CopyFrom(GLuint idSource, GLintptr iSourceOffset,
+					  GLintptr iRegionOffset, GLsizeiptr iSize);
+
+		/**
+		 * Fences the head region and advances to the next one. A
+		 * full readback ring drops its oldest region.
+		 */
+		void Submit();
+
+		size_t GetPendingCount() const;
+		bool GetIsFull() const;
+
+		/**
+		 * Readbacks dropped by Submit() on a full ring so far.
+		 */
+		size_t GetDroppedCount() const;
+
+		/**
+		 * Oldest submitted readback region, NULL if the gpu has not
+		 * finished it yet and bWait is false.
+		 */
+		const void *Fetch(bool bWait);
+		void Release();
+
+		/**
+		 * Drops all pending readbacks.
+		 */
+		void Reset();
+
+	private:
+		bool WaitFence(size_t iRegion, bool bWait);
+		void *MapRegion(size_t iRegion);
+
+		Direction m_eDirection;
+		size_t m_iRegionSize;
+		size_t m_iRegionCount;
+		bool m_bPersistent;
+
+		GLuint m_idBuffer;
+		unsigned char *m_pMapped;
+
+		std::vector<GLsync> m_vecFences;
+		size_t m_iHead;
+		size_t m_iPending;
+		size_t m_iDropped;
+	};
+}
+
+#endif // _RHAPSODIES_TRANSFERRING
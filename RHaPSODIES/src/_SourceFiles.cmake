@@ -9,8 +9,13 @@ set( DirFiles
 	ShaderRegistry.cpp
 	HandGeometry.cpp
 	HandModel.cpp
+	HandStateLayout.cpp
+	Philox.cpp
+	Halton.cpp
 	HandRenderer.cpp
 	HandTracker.cpp
+	GpuProfiler.cpp
+	TransferRing.cpp
 	CameraFramePlayer.cpp
 	CameraFrameRecorder.cpp
 	CameraFrameFilter.cpp
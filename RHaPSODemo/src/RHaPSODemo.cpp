@@ -136,7 +136,8 @@ namespace rhapsodies {
 		m_pIntersectionTextureDraw(NULL),
 		m_pDebugView(NULL),
 		m_pDepthHistogramHandler(NULL),
-		m_bFrameRecording(false) {
+		m_bFrameRecording(false),
+		m_bDifferenceView(true) {
 
 		m_pSystem = new VistaSystem;
 		m_pShaderReg = new ShaderRegistry();
@@ -251,6 +252,8 @@ namespace rhapsodies {
 													 "vista.ini"));
 		m_bFrameRecording =
 			m_oConfig.GetValueOrDefault("FRAME_RECORDING", false);
+		m_bDifferenceView =
+			m_oConfig.GetValueOrDefault("DIFFERENCE_VIEW", true);
 	}
 
 	bool RHaPSODemo::InitTracker() {
@@ -387,13 +390,18 @@ namespace rhapsodies {
 		m_pDepthCameraDraw = new ImageDraw(m_pSceneTransform, pTexDraw, pSG);
 		m_pDepthCameraDraw->GetTransformNode()->SetTranslation(VistaVector3D(0, 0,0));
 
-		// ImageDraw: difference texture
-		pTexDraw = new TexturedQuadGLDraw(
-			m_pHandTracker->GetDifferenceTextureId(),
-			true, false, m_pShaderReg, "textured_uint_diff");
+		// ImageDraw: difference texture, costs a camera depth fetch
+		// for every tile pixel. DIFFERENCE_VIEW = false skips it.
+		if(m_bDifferenceView) {
+			m_pHandTracker->SetInspectDifference(true);
+
+			pTexDraw = new TexturedQuadGLDraw(
+				m_pHandTracker->GetDifferenceTextureId(),
+				true, false, m_pShaderReg, "textured_uint_diff");
 
-		m_pDifferenceTextureDraw = new ImageDraw(m_pSceneTransform, pTexDraw, pSG);
-		m_pDifferenceTextureDraw->GetTransformNode()->SetTranslation(VistaVector3D(-2, -2,0));
+			m_pDifferenceTextureDraw = new ImageDraw(m_pSceneTransform, pTexDraw, pSG);
+			m_pDifferenceTextureDraw->GetTransformNode()->SetTranslation(VistaVector3D(-2, -2,0));
+		}
 
 		// // ImageDraw: union texture
 		// pTexDraw = new TexturedQuadGLDraw(
@@ -103,6 +103,7 @@ namespace rhapsodies {
 		DepthHistogramHandler *m_pDepthHistogramHandler;
 
 		bool m_bFrameRecording;	   
+		bool m_bDifferenceView;
 	};
 }
 
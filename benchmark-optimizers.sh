@@ -0,0 +1,71 @@
+#!/bin/sh
+
+# Compares optimizers on recorded sequences. Record one evaluation run
+# per optimizer setup (EVALUATE = true, a distinct CONDITION and the
+# OPTIMIZER or SPREAD_SEQUENCE settings in rhapsodies.ini), then pass
+# the resulting .bench files from resources/results/. Prints the mean
+# gbest penalty over all frames for each number of evaluated
+# candidates, one column per file.
+#
+# With -t, prints the mean number of generations until gbest reaches
+# the target penalty instead, over the frames that reach it, and how
+# many frames do.
+
+TARGET=
+if [ "$1" = "-t" ] && [ $# -ge 2 ]; then
+	TARGET="$2"
+	shift 2
+fi
+
+if [ $# -eq 0 ] || [ "$1" = "-t" ]; then
+	echo "usage: $0 [-t <penalty>] <file.bench> [<file.bench> ...]"
+	exit 1
+fi
+
+if [ -n "$TARGET" ]; then
+	echo "file generations reached"
+	for FILE in "$@"; do
+		printf "%s " "$(basename "$FILE" .bench)"
+		awk -v target="$TARGET" '
+			!/^#/ {
+				if($2 == 0) { frames++; done = 0 }
+				if(!done && $4 <= target) {
+					done = 1; reached++; generations += $2 + 1
+				}
+			}
+			END {
+				if(reached) printf "%.2f %d/%d\n", generations/reached, reached, frames
+				else printf "- 0/%d\n", frames
+			}' "$FILE" || exit
+	done
+	exit 0
+fi
+
+for FILE in "$@"; do
+	awk '!/^#/ { sum[$3] += $4; count[$3]++ }
+		 END { for(e in sum) print e, sum[e]/count[e] }' "$FILE" |
+		sort -k1,1 > "$FILE.mean" || exit
+done
+
+printf "evaluations"
+for FILE in "$@"; do
+	printf " %s" "$(basename "$FILE" .bench)"
+done
+printf "\n"
+
+# join all columns on the evaluation count
+RESULT=
+FIRST=1
+for FILE in "$@"; do
+	if [ -n "$FIRST" ]; then
+		RESULT=$(cat "$FILE.mean")
+		FIRST=
+	else
+		RESULT=$(echo "$RESULT" | join -a 1 -e - -o auto - "$FILE.mean")
+	fi
+done
+echo "$RESULT" | sort -n
+
+for FILE in "$@"; do
+	rm -f "$FILE.mean"
+done